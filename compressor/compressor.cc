@@ -1,75 +1,99 @@
 #include <compressor/compressor.h>
-#include <numeric>
 
 namespace compressor {
 
-EncodedItem::EncodedItem(int index, Complex value) 
+template < class Float >
+EncodedItem<Float>::EncodedItem(int index, ComplexOf<Float> value) 
 : index(index), value(value) {}
 
 // Compress / Decompress functions
-EncodedData Compress(const Data &data, int num_frequencies) {
+template < class Float >
+EncodedData<Float> Compress(const Data<Float> &data, int num_frequencies) {
 
-    const int N = (data.size() == 1) ? 1 : fft_utils::PowerOfTwo(fft_utils::IntLog2(data.size() - 1) + 1);
+    using Complex = ComplexOf<Float>;
 
-    std::vector<Complex> resized_data(N);
-    std::copy(data.begin(), data.end(), resized_data.begin());
+    const int N = data.size();
 
-    const double data_average = std::accumulate(data.begin(), data.end(), 0.) / data.size();
-    std::fill(resized_data.begin() + data.size(), resized_data.end(), data_average);
+    // The spectrum of real data is Hermitian, X_{N-k} = conj(X_k), so only the
+    // N / 2 + 1 coefficients of the half spectrum are transformed and kept.
+    const int num_coefficients = N / 2 + 1;
+    num_frequencies = std::min(num_coefficients, num_frequencies);
 
-
-    // At most N frequencies can be captured by the FFT
-    num_frequencies = std::min(N, num_frequencies);
-
-    // Data on the frequency domain
-    std::vector<Complex> data_freq(N);
-    iterative_fft::DFT(resized_data.begin(), resized_data.end(), data_freq.begin());
+    // Data on the frequency domain. The transform has the exact length of the
+    // data, so no padding distorts the spectrum.
+    std::vector<Complex> data_freq(num_coefficients);
+    const RealFftPlan<Float> plan(N, false);
+    real_fft::RFFT(data.begin(), data.end(), data_freq.begin(), plan);
 
     // Populate the EncodedData struct with frequency data
-    EncodedData compressed_data(N);
-    for (int index=0; index < N; index++) {
-        compressed_data[index] = EncodedItem(index, data_freq[index]);
+    EncodedData<Float> compressed_data(num_coefficients);
+    for (int index=0; index < num_coefficients; index++) {
+        compressed_data[index] = EncodedItem<Float>(index, data_freq[index]);
     }
 
+    // Every coefficient but X_0 and X_{N/2} also stands for its conjugate, so
+    // it carries twice its norm of the energy of the data.
+    const auto energy = [N](const EncodedItem<Float> &item) {
+        const bool is_self_conjugate = (item.index == 0 || 2 * item.index == N);
+        return (is_self_conjugate ? 1 : 2) * std::norm(item.value);
+    };
+
     // Partial sort - The first num_frequencies EncodedItem objects correspond
-    // to the num_frequencies items of data_freq with largest complex norm.
+    // to the num_frequencies items of data_freq with largest energy.
     std::nth_element(compressed_data.begin(), compressed_data.begin() + num_frequencies,
-                    compressed_data.end(), [](const EncodedItem &a, const EncodedItem &b) {
-                        return (std::norm(a.value) > std::norm(b.value));
+                    compressed_data.end(), [&energy](const EncodedItem<Float> &a, const EncodedItem<Float> &b) {
+                        return (energy(a) > energy(b));
                     });
     
-    // Discard all frequencies with small complex norm
+    // Discard all frequencies with small energy
     compressed_data.erase(compressed_data.begin() + num_frequencies, compressed_data.end());
 
     return compressed_data;
 }
 
-Data Decompress(const EncodedData &encoded_data, const int output_size) {
+template < class Float >
+Data<Float> Decompress(const EncodedData<Float> &encoded_data, const int output_size) {
 
-    const int N = (output_size == 1) ? 1 : fft_utils::PowerOfTwo(fft_utils::IntLog2(output_size - 1) + 1);
+    using Complex = ComplexOf<Float>;
 
-    std::vector<Complex> frequency_data(N);
+    const int N = output_size;
+    const int num_coefficients = N / 2 + 1;
+
+    std::vector<Complex> frequency_data(num_coefficients);
     std::fill(frequency_data.begin(), frequency_data.end(), (Complex) 0);
 
     for (const auto &item : encoded_data) {
-        assert(item.index >= 0 && item.index < N);
+        assert(item.index >= 0 && item.index < num_coefficients);
         frequency_data[item.index] = item.value;
     }
 
-    std::vector<Complex> predecoded_data(N);
-    iterative_fft::IDFT(frequency_data.begin(), frequency_data.end(), predecoded_data.begin());
-
-    std::vector<FloatType> decoded_data(N);
-    std::transform(predecoded_data.begin(), predecoded_data.end(), decoded_data.begin(),
-                    [](const Complex &x){ return x.real(); });
+    // The conjugates of the kept coefficients are implied by the inverse
+    // real transform.
+    std::vector<Float> decoded_data(N);
+    const RealFftPlan<Float> plan(N, true);
+    real_fft::IRFFT(frequency_data.begin(), frequency_data.end(), decoded_data.begin(), plan);
 
-    decoded_data.erase(decoded_data.begin() + output_size, decoded_data.end());
     return decoded_data;
 }
 
+template < class Float >
+fft_async::Future<EncodedData<Float>> AsyncCompress(Data<Float> data, int num_frequencies) {
+    return fft_async::Async([data = std::move(data), num_frequencies](){
+        return Compress(data, num_frequencies);
+    });
+}
+
+template < class Float >
+fft_async::Future<Data<Float>> AsyncDecompress(EncodedData<Float> encoded_data, const int output_size) {
+    return fft_async::Async([encoded_data = std::move(encoded_data), output_size](){
+        return Decompress(encoded_data, output_size);
+    });
+}
+
 
 /// utils
-Data ReadDataFromStdin() {
+template < class Float >
+Data<Float> ReadDataFromStdin() {
     int size_sequence;
     std::cin >> size_sequence;
 
@@ -78,7 +102,7 @@ Data ReadDataFromStdin() {
         exit(1);
     }
 
-    Data data(size_sequence);
+    Data<Float> data(size_sequence);
 
     for (int i=0; i < size_sequence; i++) {
         std::cin >> data[i];
@@ -87,7 +111,8 @@ Data ReadDataFromStdin() {
     return data;
 }
 
-void WriteDataToStdout(const Data &data) {
+template < class Float >
+void WriteDataToStdout(const Data<Float> &data) {
     std::cout << data.size() << "\n";
     for (const auto &elem : data) {
         std::cout << elem << " ";
@@ -95,4 +120,20 @@ void WriteDataToStdout(const Data &data) {
     std::cout << "\n";
 }
 
+// The supported precisions
+#define COMPRESSOR_INSTANTIATE(Float) \
+    template struct EncodedItem<Float>; \
+    template EncodedData<Float> Compress<Float>(const Data<Float> &, int); \
+    template Data<Float> Decompress<Float>(const EncodedData<Float> &, const int); \
+    template fft_async::Future<EncodedData<Float>> AsyncCompress<Float>(Data<Float>, int); \
+    template fft_async::Future<Data<Float>> AsyncDecompress<Float>(EncodedData<Float>, const int); \
+    template Data<Float> ReadDataFromStdin<Float>(); \
+    template void WriteDataToStdout<Float>(const Data<Float> &);
+
+COMPRESSOR_INSTANTIATE(float)
+COMPRESSOR_INSTANTIATE(double)
+COMPRESSOR_INSTANTIATE(long double)
+
+#undef COMPRESSOR_INSTANTIATE
+
 }; // namespace compressor
\ No newline at end of file
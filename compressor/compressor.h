@@ -8,29 +8,51 @@
 #include <vector>
 
 #include <core/dft.h>
+#include <core/async.h>
 
 namespace compressor {
 
-/// Stores one component of the Discrete Fourier Transform of the Data.
+/// Stores one component of the Discrete Fourier Transform of the Data, an
+/// index of the half spectrum: 0 <= index <= N / 2.
+/// Float is the precision used by the transforms; float, double and long
+/// double are instantiated in compressor.cc.
+template < class Float = FloatType >
 struct EncodedItem {
     int index;
-    Complex value;
+    ComplexOf<Float> value;
 
     EncodedItem() = default;
-    EncodedItem(int index, Complex value);
+    EncodedItem(int index, ComplexOf<Float> value);
 };
 
-using Data = std::vector<FloatType>;
-using EncodedData = std::vector<EncodedItem>;
+template < class Float = FloatType >
+using Data = std::vector<Float>;
 
-EncodedData Compress(const std::vector<FloatType> &data, int num_frequencies=DEFAULT_NUM_FREQUENCIES);
-Data Decompress(const EncodedData &encoded_data, const int N);
+template < class Float = FloatType >
+using EncodedData = std::vector<EncodedItem<Float>>;
+
+template < class Float >
+EncodedData<Float> Compress(const Data<Float> &data, int num_frequencies=DEFAULT_NUM_FREQUENCIES);
+
+template < class Float >
+Data<Float> Decompress(const EncodedData<Float> &encoded_data, const int N);
+
+/// Compress and Decompress as tasks of the shared pool of the library. They
+/// take their input by value and return at once, so that the caller can read
+/// the next input or write the last output meanwhile.
+template < class Float >
+fft_async::Future<EncodedData<Float>> AsyncCompress(Data<Float> data, int num_frequencies=DEFAULT_NUM_FREQUENCIES);
+
+template < class Float >
+fft_async::Future<Data<Float>> AsyncDecompress(EncodedData<Float> encoded_data, const int N);
 
 
 /// utils
-Data ReadDataFromStdin();
+template < class Float >
+Data<Float> ReadDataFromStdin();
 
-void WriteDataToStdout(const Data &data);
+template < class Float >
+void WriteDataToStdout(const Data<Float> &data);
 
 }; // namespace compressor
 
@@ -1,46 +1,46 @@
 #include <iostream>
 #include <random>
+#include <string>
 
 #include <compressor/compressor.h>
 
-static void PrintData(const compressor::Data &data) {
-    std::cout << "Data " << data.size() << " elements\n";
-    for(const auto &elem : data) {
-        std::cout << elem << " ";
-    }
-    std::cout << "\n";
-}
+template < class Float >
+static void Run(int num_frequencies) {
+    compressor::Data<Float> data = compressor::ReadDataFromStdin<Float>();
+    compressor::EncodedData<Float> compressed_data = compressor::Compress(data, num_frequencies);
 
-static void PrintEncodedData(const compressor::EncodedData &data) {
-    std::cout << "Encoded Data " << data.size() << " elements\n";
-    for(const auto &elem : data) {
-        std::cout << "(" << elem.index  << ", " << elem.value << ") ";
-    }
-    std::cout << "\n";
-}
-
-static void PrintFft(const std::vector<Complex> &sequence) {
-    std::cout << "Fft Coefficients " << sequence.size() << " elements\n";
-    for(const auto &elem : sequence) {
-        std::cout << elem << " ";
-    }
-    std::cout << "\n";
+    compressor::Data<Float> reconstructed_data = compressor::Decompress(compressed_data, data.size());
+    compressor::WriteDataToStdout(reconstructed_data);
 }
 
 int main(int argc, char **argv) {
 
-    if (argc != 2) {
-        printf("Usage: %s [num_frequencies]\n", argv[0]);
+    if (argc != 2 && argc != 3) {
+        printf("Usage: %s [num_frequencies] [PRECISION]\n", argv[0]);
         printf("\tnum_frequencies dictates the quality of the compression. \n");
         printf("\tThe more frequencies you use, the better the approximation but the compression is smaller. \n");
+        printf("\t[PRECISION] (optional) can take the following values:\n");
+        printf("\t\t `f` for float\n");
+        printf("\t\t `d` for double\n");
+        printf("\t\t `l` (default) for long double\n");
         exit(1);
     }
 
     int num_frequencies = std::stoi(argv[1]);
 
-    compressor::Data data = compressor::ReadDataFromStdin();
-    compressor::EncodedData compressed_data = compressor::Compress(data, num_frequencies);
+    const std::string precision = (argc == 3) ? argv[2] : "l";
 
-    compressor::Data reconstructed_data = compressor::Decompress(compressed_data, data.size());
-    compressor::WriteDataToStdout(reconstructed_data);
+    if (precision == "f") {
+        Run<float>(num_frequencies);
+    }
+    else if (precision == "d") {
+        Run<double>(num_frequencies);
+    }
+    else if (precision == "l") {
+        Run<long double>(num_frequencies);
+    }
+    else {
+        printf("Invalid precision.\n");
+        exit(1);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <core/affinity.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    // The CPUs of a list such as "0-3,8,10-11"
+    std::vector<int> ParseCpuList(const std::string &list) {
+        std::vector<int> cpus;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (item.empty() || item == "\n") {
+                continue;
+            }
+            const size_t dash = item.find('-');
+            const int first = std::stoi(item.substr(0, dash));
+            const int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    std::vector<int> AllowedCpus() {
+        std::vector<int> cpus;
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &mask)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        if (cpus.empty()) {
+            cpus.push_back(0);
+        }
+        return cpus;
+    }
+
+    // The nodes in the order of their numbers, restricted to the allowed
+    // CPUs. Empty if /sys has no node information.
+    std::vector<std::vector<int>> ReadNodes(const std::vector<int> &allowed) {
+        namespace fs = std::filesystem;
+
+        std::vector<std::pair<int, std::vector<int>>> numbered_nodes;
+        std::error_code error;
+        for (fs::directory_iterator it("/sys/devices/system/node", error), end; !error && it != end; it.increment(error)) {
+            const std::string name = it->path().filename().string();
+            if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+                !std::all_of(name.begin() + 4, name.end(), [](char c){ return std::isdigit((unsigned char) c); })) {
+                continue;
+            }
+
+            std::ifstream file(it->path() / "cpulist");
+            std::string list;
+            std::getline(file, list);
+
+            std::vector<int> cpus;
+            for (const int cpu : ParseCpuList(list)) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) {
+                numbered_nodes.emplace_back(std::stoi(name.substr(4)), cpus);
+            }
+        }
+
+        std::sort(numbered_nodes.begin(), numbered_nodes.end());
+        std::vector<std::vector<int>> nodes;
+        for (auto &node : numbered_nodes) {
+            nodes.push_back(std::move(node.second));
+        }
+        return nodes;
+    }
+}
+
+CpuTopology::CpuTopology(std::vector<std::vector<int>> nodes)
+    : m_nodes(std::move(nodes)) {
+    assert(!m_nodes.empty());
+    for (const auto &node : m_nodes) {
+        m_cpus.insert(m_cpus.end(), node.begin(), node.end());
+    }
+    assert(!m_cpus.empty());
+}
+
+const CpuTopology& CpuTopology::Detect() {
+    static const CpuTopology topology = [](){
+        const std::vector<int> allowed = AllowedCpus();
+        std::vector<std::vector<int>> nodes = ReadNodes(allowed);
+        if (nodes.empty()) {
+            nodes.push_back(allowed);
+        }
+        return CpuTopology(std::move(nodes));
+    }();
+    return topology;
+}
+
+size_t CpuTopology::num_nodes() const {
+    return m_nodes.size();
+}
+
+size_t CpuTopology::num_cpus() const {
+    return m_cpus.size();
+}
+
+const std::vector<int>& CpuTopology::node_cpus(const size_t node) const {
+    return m_nodes[node];
+}
+
+int CpuTopology::cpu_of_thread(const size_t thread_id, const size_t num_threads) const {
+    const size_t num_cpus = m_cpus.size();
+    // More threads than CPUs go round the CPUs again
+    const size_t slot = (num_threads <= num_cpus) ? thread_id * num_cpus / num_threads : thread_id % num_cpus;
+    return m_cpus[slot];
+}
+
+struct ScopedThreadPin::SavedMask {
+    cpu_set_t mask;
+};
+
+ScopedThreadPin::ScopedThreadPin(const int cpu)
+    : m_saved(std::make_unique<SavedMask>()) {
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(m_saved->mask), &m_saved->mask) != 0) {
+        return;
+    }
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    m_is_pinned = (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0);
+}
+
+ScopedThreadPin::~ScopedThreadPin() {
+    if (m_is_pinned) {
+        pthread_setaffinity_np(pthread_self(), sizeof(m_saved->mask), &m_saved->mask);
+    }
+}
+
+bool ScopedThreadPin::is_pinned() const {
+    return m_is_pinned;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#ifndef CORE_AFFINITY_H
+#define CORE_AFFINITY_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// How the threads of a parallelizer are placed on the CPUs.
+enum class ThreadPlacement {
+    // Wherever the scheduler puts them
+    kFloating,
+    // Each thread of a team pinned to one CPU, the team split between the
+    // NUMA nodes in consecutive blocks, see CpuTopology::cpu_of_thread.
+    kPinned
+};
+
+/// The CPUs the process may run on, grouped by NUMA node as listed in
+/// /sys/devices/system/node. A machine without that information is one node.
+class CpuTopology {
+public:
+    explicit CpuTopology(std::vector<std::vector<int>> nodes);
+
+    /// The topology of this machine, read once.
+    static const CpuTopology& Detect();
+
+    size_t num_nodes() const;
+    size_t num_cpus() const;
+    const std::vector<int>& node_cpus(const size_t node) const;
+
+    /// CPU of the thread thread_id of a team of num_threads threads. The
+    /// threads spread evenly over the CPUs, taken node after node, so that
+    /// consecutive threads, which get consecutive chunks of a parallel_for,
+    /// share a node.
+    int cpu_of_thread(const size_t thread_id, const size_t num_threads) const;
+
+private:
+    std::vector<std::vector<int>> m_nodes;
+    // The CPUs of all nodes, node after node
+    std::vector<int> m_cpus;
+};
+
+/// Pins the calling thread to cpu for the lifetime of the object, then
+/// gives the thread back the CPUs it had.
+class ScopedThreadPin {
+public:
+    explicit ScopedThreadPin(const int cpu);
+    ~ScopedThreadPin();
+
+    ScopedThreadPin(const ScopedThreadPin&) = delete;
+    ScopedThreadPin& operator=(const ScopedThreadPin&) = delete;
+
+    /// False if the system refused the new affinity.
+    bool is_pinned() const;
+
+private:
+    struct SavedMask;
+    std::unique_ptr<SavedMask> m_saved;
+    bool m_is_pinned = false;
+};
+
+/// Buffer of n default values initialized by parallelizer.parallel_for in
+/// ranges of grain elements. The kernel places a page on the NUMA node of the
+/// thread that first writes it, so with a FixedThreadsParallelizer in
+/// ThreadPlacement::kPinned each range lands on the node of the thread that
+/// gets the same range in a later parallel_for with the same grain. The
+/// other parallelizers do not pin their threads.
+template < class T >
+class FirstTouchBuffer {
+public:
+    static constexpr size_t DEFAULT_GRAIN = size_t{1} << 12;
+
+    template < class Parallelizer >
+    FirstTouchBuffer(const size_t n, const Parallelizer &parallelizer, const size_t grain = DEFAULT_GRAIN)
+        : m_data(std::allocator<T>().allocate(n)), m_size(n) {
+        parallelizer.parallel_for(size_t{0}, n, grain, [this](const size_t first, const size_t last) {
+            for (size_t i = first; i < last; i++) {
+                ::new ((void*) (m_data + i)) T();
+            }
+        });
+    }
+
+    ~FirstTouchBuffer() {
+        for (size_t i = 0; i < m_size; i++) {
+            m_data[i].~T();
+        }
+        std::allocator<T>().deallocate(m_data, m_size);
+    }
+
+    FirstTouchBuffer(const FirstTouchBuffer&) = delete;
+    FirstTouchBuffer& operator=(const FirstTouchBuffer&) = delete;
+
+    T* begin() { return m_data; }
+    T* end() { return m_data + m_size; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
+    T& operator[](const size_t i) { return m_data[i]; }
+    const T& operator[](const size_t i) const { return m_data[i]; }
+
+    size_t size() const { return m_size; }
+
+private:
+    T *m_data;
+    size_t m_size;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#pragma once
+
+#ifndef CORE_ASYNC_H
+#define CORE_ASYNC_H
+
+#include <core/parallel.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/// Asynchronous calls on the workers of a ThreadPoolParallelizer, by default
+/// the shared pool of the library.
+///
+/// Async(func) returns a Future of the result of func at once. A Future can
+/// be chained with then(), which runs its function on the pool as soon as
+/// the result is there, without blocking any thread, and WhenAll() joins
+/// several of them. Together they describe a small task graph, such as the
+/// two forward transforms and the inverse transform of a product.
+///
+/// A thread that waits for a Future runs the submitted tasks that are still
+/// pending meanwhile, so that waiting from inside a task cannot deadlock the
+/// pool.
+namespace fft_async {
+
+    template < class T >
+    class Future;
+
+    namespace async_detail {
+        // The value of a Future<void>
+        using Unit = std::monostate;
+
+        template < class T >
+        using Stored = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+        // Result of a continuation of a Future<T>
+        template < class T, class Func >
+        struct ContinuationResult {
+            using type = std::invoke_result_t<Func, const T&>;
+        };
+
+        template < class Func >
+        struct ContinuationResult<void, Func> {
+            using type = std::invoke_result_t<Func>;
+        };
+
+        template < class T >
+        struct SharedState {
+            const ThreadPoolParallelizer *pool;
+
+            std::mutex mutex;
+            std::condition_variable done;
+            bool is_ready = false;
+            std::optional<Stored<T>> value;
+            std::exception_ptr error;
+
+            // Run on the thread that completes the state
+            std::vector<std::function<void(void)>> callbacks;
+
+            explicit SharedState(const ThreadPoolParallelizer *pool) : pool(pool) {}
+
+            void on_ready(std::function<void(void)> callback) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!is_ready) {
+                        callbacks.push_back(std::move(callback));
+                        return;
+                    }
+                }
+                callback();
+            }
+
+            void complete(std::optional<Stored<T>> new_value, std::exception_ptr new_error) {
+                std::vector<std::function<void(void)>> ready_callbacks;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    value = std::move(new_value);
+                    error = new_error;
+                    is_ready = true;
+                    ready_callbacks.swap(callbacks);
+                }
+                done.notify_all();
+
+                for (auto &callback : ready_callbacks) {
+                    callback();
+                }
+            }
+        };
+
+        // Completes state with the result of func(args...), or with the
+        // exception it throws.
+        template < class T, class Func, class... Args >
+        void Fulfill(SharedState<T> &state, Func &func, Args&&... args) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    func(std::forward<Args>(args)...);
+                    state.complete(Unit{}, nullptr);
+                } else {
+                    state.complete(func(std::forward<Args>(args)...), nullptr);
+                }
+            } catch (...) {
+                state.complete(std::nullopt, std::current_exception());
+            }
+        }
+    }; // namespace async_detail
+
+    /// Result of an asynchronous call. Copies share the same result.
+    template < class T >
+    class Future {
+    public:
+        using State = async_detail::SharedState<T>;
+
+        Future() = default;
+        explicit Future(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+        bool valid() const {
+            return m_state != nullptr;
+        }
+
+        bool is_ready() const {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            return m_state->is_ready;
+        }
+
+        /// Waits for the result, running pending tasks of the pool meanwhile.
+        void wait() const {
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+            while (!m_state->is_ready) {
+                lock.unlock();
+                if (!m_state->pool->run_pending_task()) {
+                    lock.lock();
+                    m_state->done.wait_for(lock, std::chrono::milliseconds(1), [this](){ return m_state->is_ready; });
+                } else {
+                    lock.lock();
+                }
+            }
+        }
+
+        /// Waits for the result and returns it, or rethrows the exception of
+        /// the call.
+        decltype(auto) get() const {
+            wait();
+            if (m_state->error) {
+                std::rethrow_exception(m_state->error);
+            }
+            if constexpr (!std::is_void_v<T>) {
+                return static_cast<const T&>(*m_state->value);
+            }
+        }
+
+        /// Runs func on the pool once the result is there, with the result as
+        /// argument unless T is void. An exception of this call skips func and
+        /// goes to the returned Future.
+        template < class Func >
+        auto then(Func func) const {
+            using U = typename async_detail::ContinuationResult<T, Func>::type;
+
+            auto next = std::make_shared<async_detail::SharedState<U>>(m_state->pool);
+            auto state = m_state;
+
+            state->on_ready([state, next, func = std::move(func)]() mutable {
+                state->pool->submit([state, next, func = std::move(func)]() mutable {
+                    if (state->error) {
+                        next->complete(std::nullopt, state->error);
+                    } else if constexpr (std::is_void_v<T>) {
+                        async_detail::Fulfill(*next, func);
+                    } else {
+                        async_detail::Fulfill(*next, func, static_cast<const T&>(*state->value));
+                    }
+                });
+            });
+
+            return Future<U>(next);
+        }
+
+        /// Calls callback on the thread that completes the call, or at once if
+        /// it is complete. For short bookkeeping only.
+        void on_ready(std::function<void(void)> callback) const {
+            m_state->on_ready(std::move(callback));
+        }
+
+        std::exception_ptr error() const {
+            wait();
+            return m_state->error;
+        }
+
+        const ThreadPoolParallelizer& pool() const {
+            return *m_state->pool;
+        }
+
+    private:
+        std::shared_ptr<State> m_state;
+    };
+
+    /// Runs func() on a worker of pool.
+    template < class Func >
+    auto Async(const ThreadPoolParallelizer &pool, Func func) {
+        using T = std::invoke_result_t<Func>;
+
+        auto state = std::make_shared<async_detail::SharedState<T>>(&pool);
+        pool.submit([state, func = std::move(func)]() mutable {
+            async_detail::Fulfill(*state, func);
+        });
+
+        return Future<T>(state);
+    }
+
+    /// Runs func() on a worker of the shared pool.
+    template < class Func >
+    auto Async(Func func) {
+        return Async(ThreadPoolParallelizer::Shared(), std::move(func));
+    }
+
+    /// A Future that already holds value, for a result that is cheaper to
+    /// compute on the spot than to submit. Its continuations run on pool.
+    template < class T >
+    Future<std::decay_t<T>> Ready(T &&value, const ThreadPoolParallelizer &pool = ThreadPoolParallelizer::Shared()) {
+        using U = std::decay_t<T>;
+
+        auto state = std::make_shared<async_detail::SharedState<U>>(&pool);
+        state->complete(std::forward<T>(value), nullptr);
+        return Future<U>(state);
+    }
+
+    /// Ready once all of the futures are. Carries the first exception among
+    /// them, in argument order.
+    template < class T, class... Ts >
+    Future<void> WhenAll(const Future<T> &future, const Future<Ts>&... futures) {
+        auto state = std::make_shared<async_detail::SharedState<void>>(&future.pool());
+        auto num_left = std::make_shared<std::atomic<size_t>>(1 + sizeof...(Ts));
+
+        // The last one to complete collects the errors
+        auto check_all = [=]() {
+            std::exception_ptr error;
+            for (const std::exception_ptr &e : {future.error(), futures.error()...}) {
+                if (!error) {
+                    error = e;
+                }
+            }
+            state->complete(async_detail::Unit{}, error);
+        };
+
+        const auto count_down = [=]() {
+            if (num_left->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                check_all();
+            }
+        };
+
+        future.on_ready(count_down);
+        (futures.on_ready(count_down), ...);
+
+        return Future<void>(state);
+    }
+}; // namespace fft_async
+
+#endif
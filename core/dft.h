@@ -4,6 +4,8 @@
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <type_traits>
+#include <optional>
 
 // Multithreading
 #include <thread>
@@ -11,8 +13,12 @@
 
 #include <core/fft_types.h>
 #include <core/fft_utils.h>
+#include <core/fft_plan.h>
+#include <core/simd_kernels.h>
+#include <core/fft_codelets.h>
 
-#define RECURSIVE_FFT_BASE_CASE_SIZE 1
+// Transforms up to this size run as a single codelet, without a plan.
+#define RECURSIVE_FFT_BASE_CASE_SIZE fft_codelets::CODELET_MAX_SIZE
 
 namespace dft_detail {
     template < class InputIt, class OutputIt >
@@ -23,26 +29,569 @@ namespace dft_detail {
         return (mem_addr_src == mem_addr_dst);
     }
 
+    // Raw pointers and vector iterators address contiguous memory, which is
+    // what the SIMD kernels need.
+    template < class It >
+    constexpr bool IsContiguous() {
+        using ValueType = typename std::iterator_traits<It>::value_type;
+        return std::is_pointer<It>::value || std::is_same<It, typename std::vector<ValueType>::iterator>::value;
+    }
+
+    // One radix 2 stage of the iterative FFT over data[0...n), see
+    // simd::RadixTwoStage. Contiguous float and double data in the precision
+    // of the twiddles goes through the SIMD kernels.
+    template < class OutputIt, class Float >
+    void RadixTwoStage(OutputIt data, size_t n, size_t half, const std::complex<Float> *twiddles) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        constexpr bool use_simd = IsContiguous<OutputIt>()
+            && std::is_same<ComplexType, std::complex<Float>>::value
+            && (std::is_same<Float, float>::value || std::is_same<Float, double>::value);
+
+        if constexpr (use_simd) {
+            simd::RadixTwoStage(&data[0], n, half, twiddles);
+        }
+        else {
+            for (size_t k = 0; k < n; k += 2 * half) {
+                for (size_t j = 0; j < half; j++) {
+                    ComplexType a = data[k + j];
+                    ComplexType b = (ComplexType) twiddles[j] * data[k + j + half];
+                    data[k + j] = a + b;
+                    data[k + j + half] = a - b;
+                }
+            }
+        }
+    }
+
+    // The columns j in [j_first, j_last) of one radix 2 stage on the single
+    // block data[0...2 * half), with the SIMD kernels of RadixTwoStage.
+    template < class OutputIt, class Float >
+    void RadixTwoColumns(OutputIt data, size_t half, size_t j_first, size_t j_last, const std::complex<Float> *twiddles) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        constexpr bool use_simd = IsContiguous<OutputIt>()
+            && std::is_same<ComplexType, std::complex<Float>>::value
+            && (std::is_same<Float, float>::value || std::is_same<Float, double>::value);
+
+        if constexpr (use_simd) {
+            simd::RadixTwoStage(&data[0], half, j_first, j_last, twiddles);
+        }
+        else {
+            for (size_t j = j_first; j < j_last; j++) {
+                ComplexType a = data[j];
+                ComplexType b = (ComplexType) twiddles[j] * data[j + half];
+                data[j] = a + b;
+                data[j + half] = a - b;
+            }
+        }
+    }
+
+    // Product of complex numbers that are known to be finite. The std::complex
+    // operator also handles the infinities of C99 Annex G, a branch that keeps
+    // GCC from optimizing the loops around it.
+    template < class ComplexType >
+    inline ComplexType MultiplyFinite(const ComplexType &a, const ComplexType &b) {
+        return ComplexType(a.real() * b.real() - a.imag() * b.imag(),
+                           a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    // Product by exp(-+ 2 PI i / 4), -i for the forward transform and i for
+    // the inverse: a swap of the parts and a negation.
+    template < bool IsInverse, class ComplexType >
+    inline ComplexType RotateQuarter(const ComplexType &z) {
+        return IsInverse ? ComplexType(-z.imag(), z.real()) : ComplexType(z.imag(), -z.real());
+    }
+
+    // Product by exp(-+ 2 PI i / 8) = (1 -+ i) / sqrt(2).
+    template < bool IsInverse, class ComplexType >
+    inline ComplexType RotateEighth(const ComplexType &z) {
+        using Float = typename ComplexType::value_type;
+        constexpr Float sqrt_half = (Float) 0.707106781186547524400844362104849039L;
+        return IsInverse ? ComplexType(sqrt_half * (z.real() - z.imag()), sqrt_half * (z.real() + z.imag()))
+                         : ComplexType(sqrt_half * (z.real() + z.imag()), sqrt_half * (z.imag() - z.real()));
+    }
+
+    // FusedRadixColumns for one direction of the transform.
+    template < size_t R, bool IsInverse, class OutputIt, class Float >
+    void RadixButterflies(OutputIt data, int s, size_t j_first, size_t j_last, const FftPlan<Float> &plan) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        constexpr int r = (R == 2) ? 1 : (R == 4) ? 2 : 3;
+        static_assert(R == size_t{1} << r, "R must be 2, 4 or 8");
+
+        // Bit reversal of m < R on r bits
+        constexpr size_t reversed[8] = {0, 4, 2, 6, 1, 5, 3, 7};
+
+        const size_t h = size_t{1} << (s - 1);
+
+        // w^e = exp(-+ 2 PI i e / Rh) for e < Rh/2, and w^e = -w^(e - Rh/2)
+        // above.
+        const std::complex<Float> *twiddles = plan.StageTwiddles(s + r - 1);
+        const size_t half_turn = R * h / 2;
+
+        for (size_t j = j_first; j < j_last; j++) {
+            ComplexType v[R];
+            v[0] = data[j];
+            #pragma GCC unroll 8
+            for (size_t m = 1; m < R; m++) {
+                const size_t e = (reversed[m] >> (3 - r)) * j;
+                const ComplexType w = (e < half_turn) ? (ComplexType) twiddles[e] : -(ComplexType) twiddles[e - half_turn];
+                v[m] = MultiplyFinite(w, (ComplexType) data[j + m * h]);
+            }
+
+            #pragma GCC unroll 4
+            for (size_t m = 0; m < R; m += 2) {
+                const ComplexType a = v[m];
+                const ComplexType b = v[m + 1];
+                v[m] = a + b;
+                v[m + 1] = a - b;
+            }
+
+            if constexpr (r >= 2) {
+                #pragma GCC unroll 2
+                for (size_t m = 0; m < R; m += 4) {
+                    const ComplexType a0 = v[m];
+                    const ComplexType b0 = v[m + 2];
+                    v[m] = a0 + b0;
+                    v[m + 2] = a0 - b0;
+
+                    const ComplexType a1 = v[m + 1];
+                    const ComplexType b1 = RotateQuarter<IsInverse>(v[m + 3]);
+                    v[m + 1] = a1 + b1;
+                    v[m + 3] = a1 - b1;
+                }
+            }
+
+            if constexpr (r == 3) {
+                const ComplexType b[4] = {
+                    v[4],
+                    RotateEighth<IsInverse>(v[5]),
+                    RotateQuarter<IsInverse>(v[6]),
+                    RotateEighth<IsInverse>(RotateQuarter<IsInverse>(v[7])),
+                };
+                #pragma GCC unroll 4
+                for (size_t m = 0; m < 4; m++) {
+                    const ComplexType a = v[m];
+                    v[m] = a + b[m];
+                    v[m + 4] = a - b[m];
+                }
+            }
+
+            #pragma GCC unroll 8
+            for (size_t m = 0; m < R; m++) {
+                data[j + m * h] = v[m];
+            }
+        }
+    }
+
+    // Runs log2(R) radix 2 stages, starting at stage s, as one radix R pass
+    // over the block data[0...R * h), h = 2^(s-1). The R values at distance h
+    // of a column j are loaded once, multiplied by the twiddles
+    // w^(rev(m) * j), w = exp(-+ 2 PI i / Rh), and combined by a transform of
+    // length R whose roots are 1, -+i and (1 -+ i) / sqrt(2), which cost no
+    // multiplication or two. That is R - 1 complex products per column
+    // instead of log2(R) * R / 2. Only the columns j in [j_first, j_last),
+    // j < h, are handled.
+    template < size_t R, class OutputIt, class Float >
+    void FusedRadixColumns(OutputIt data, int s, size_t j_first, size_t j_last, const FftPlan<Float> &plan) {
+        if (plan.IsInverse()) {
+            RadixButterflies<R, true>(data, s, j_first, j_last, plan);
+        } else {
+            RadixButterflies<R, false>(data, s, j_first, j_last, plan);
+        }
+    }
+
+    // FusedRadixColumns on every block of R * 2^(s-1) values of data[0...n).
+    template < size_t R, class OutputIt, class Float >
+    void FusedRadixPass(OutputIt data, size_t n, int s, const FftPlan<Float> &plan) {
+        const size_t h = size_t{1} << (s - 1);
+        for (size_t k = 0; k < n; k += R * h) {
+            FusedRadixColumns<R>(data + k, s, 0, h, plan);
+        }
+    }
+
+    // One pass of the iterative engine: r fused radix 2 stages starting at
+    // stage s over data[0...n).
+    template < class OutputIt, class Float >
+    void RadixPass(OutputIt data, size_t n, int s, int r, const FftPlan<Float> &plan) {
+        switch (r) {
+            case 1:
+                RadixTwoStage(data, n, size_t{1} << (s - 1), plan.StageTwiddles(s));
+                break;
+            case 2:
+                FusedRadixPass<4>(data, n, s, plan);
+                break;
+            case 3:
+                FusedRadixPass<8>(data, n, s, plan);
+                break;
+            default:
+                assert(false);
+        }
+    }
+
+    // The columns j in [j_first, j_last) of one pass on the single block
+    // data[0...2^(s-1+r)). The parallel engine splits the few large blocks of
+    // the last passes this way between its threads.
+    template < class OutputIt, class Float >
+    void RadixPassColumns(OutputIt data, int s, int r, size_t j_first, size_t j_last, const FftPlan<Float> &plan) {
+        switch (r) {
+            case 1:
+                RadixTwoColumns(data, size_t{1} << (s - 1), j_first, j_last, plan.StageTwiddles(s));
+                break;
+            case 2:
+                FusedRadixColumns<4>(data, s, j_first, j_last, plan);
+                break;
+            case 3:
+                FusedRadixColumns<8>(data, s, j_first, j_last, plan);
+                break;
+            default:
+                assert(false);
+        }
+    }
+
+    // Runs the passes of the plan from stage first_stage on, over
+    // data[0...n). A pass that starts before first_stage is cut down to its
+    // remaining stages.
+    template < class OutputIt, class Float >
+    void RadixPasses(OutputIt data, size_t n, int first_stage, const FftPlan<Float> &plan) {
+        int s = 1;
+        for (int r : plan.Passes()) {
+            const int done = std::min(r, std::max(0, first_stage - s));
+            if (done < r) {
+                RadixPass(data, n, s + done, r - done, plan);
+            }
+            s += r;
+        }
+    }
+
+    // Multiplies data[0...n) by scale, which costs nothing for scale == 1.
+    template < class OutputIt, class Float >
+    void Scale(OutputIt data, size_t n, Float scale) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using DataFloat = typename ComplexType::value_type;
+
+        if (scale == (Float) 1) {
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            data[i] *= (DataFloat) scale;
+        }
+    }
+
+    // Replaces the bit reversal and the first leaf_log stages of the iterative
+    // engine with codelets of size L = 2^leaf_log. After the bit reversal, the
+    // block of d_first at L * rev(r) would hold the terms r + j * (n / L),
+    // j < L, in bit reversed order, and the first stages would transform
+    // them; the codelet does both at once. Only the r in [r_first, r_last)
+    // are handled. Consecutive r read neighbouring elements, so the strided
+    // reads share their cache lines. The leaves also multiply their output by
+    // scale while it is still in cache, which spares the normalization its
+    // own pass over the data.
+    template < class InputIt, class OutputIt, class Float >
+    void CodeletLeaves(InputIt first, size_t stride, OutputIt d_first, int logn, int leaf_log,
+                       size_t r_first, size_t r_last, bool is_inverse_transform, Float scale) {
+        const int blocks_log = logn - leaf_log;
+        const size_t blocks = size_t{1} << blocks_log;
+
+        for (size_t r = r_first; r < r_last; r++) {
+            OutputIt leaf = d_first + (fft_utils::ReverseBits(r, blocks_log) << leaf_log);
+            fft_codelets::RunCodelet(leaf_log, is_inverse_transform, first + stride * r, stride * blocks, leaf);
+            Scale(leaf, size_t{1} << leaf_log, scale);
+        }
+    }
+
+    // In place version of CodeletLeaves on data that was already bit
+    // reversed: every block of L = 2^leaf_log values goes through a codelet
+    // that reads its input in bit reversed order. Only the blocks in
+    // [r_first, r_last) are handled.
+    template < class OutputIt, class Float >
+    void BitReversedLeaves(OutputIt data, int leaf_log, size_t r_first, size_t r_last,
+                           bool is_inverse_transform, Float scale) {
+        for (size_t r = r_first; r < r_last; r++) {
+            OutputIt leaf = data + (r << leaf_log);
+            fft_codelets::RunBitReversedCodelet(leaf_log, is_inverse_transform, leaf);
+            Scale(leaf, size_t{1} << leaf_log, scale);
+        }
+    }
+
+    // Split radix combination of a transform of length n = 2^logn whose input
+    // was bit reversed. data[0...n/2) holds the transform of the even terms,
+    // data[n/2...3n/4) and data[3n/4...n) those of the terms 4m+1 and 4m+3.
+    // Only the k in [k_first, k_last) are combined.
+    template < bool IsInverse, class OutputIt, class Float >
+    void SplitRadixButterflies(OutputIt data, int logn, size_t k_first, size_t k_last, const FftPlan<Float> &plan) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const size_t n = size_t{1} << logn;
+        const size_t quarter = n / 4;
+        const auto twiddles = plan.StageTwiddles(logn);
+
+        const auto butterfly = [&](size_t k, const ComplexType &w3) {
+            const ComplexType u0 = data[k];
+            const ComplexType u1 = data[k + quarter];
+            const ComplexType z0 = MultiplyFinite((ComplexType) twiddles[k], (ComplexType) data[k + 2 * quarter]);
+            const ComplexType z1 = MultiplyFinite(w3, (ComplexType) data[k + 3 * quarter]);
+
+            const ComplexType sum = z0 + z1;
+            const ComplexType diff = RotateQuarter<IsInverse>(z0 - z1);
+
+            data[k] = u0 + sum;
+            data[k + 2 * quarter] = u0 - sum;
+            data[k + quarter] = u1 + diff;
+            data[k + 3 * quarter] = u1 - diff;
+        };
+
+        // w^(3k) = -w^(3k - n/2) when 3k >= n/2, that is from k = k_wrap on
+        const size_t k_wrap = std::clamp((n / 2 + 2) / 3, k_first, k_last);
+        for (size_t k = k_first; k < k_wrap; k++) {
+            butterfly(k, (ComplexType) twiddles[3 * k]);
+        }
+        for (size_t k = k_wrap; k < k_last; k++) {
+            butterfly(k, -(ComplexType) twiddles[3 * k - n / 2]);
+        }
+    }
+
+    template < class OutputIt, class Float >
+    void SplitRadixCombine(OutputIt data, int logn, size_t k_first, size_t k_last, const FftPlan<Float> &plan) {
+        if (plan.IsInverse()) {
+            SplitRadixButterflies<true>(data, logn, k_first, k_last, plan);
+        } else {
+            SplitRadixButterflies<false>(data, logn, k_first, k_last, plan);
+        }
+    }
+
+    // The recursion ends at the codelets, which take their input in the bit
+    // reversed order that every block of the recursion is in.
+    template < class OutputIt, class Float >
+    void SplitRadix(OutputIt data, int logn, const FftPlan<Float> &plan) {
+        if (logn <= fft_codelets::CODELET_LEAF_LOG_SIZE) {
+            fft_codelets::RunBitReversedCodelet(logn, plan.IsInverse(), data);
+            return;
+        }
+
+        const size_t n = size_t{1} << logn;
+        SplitRadix(data, logn - 1, plan);
+        SplitRadix(data + n / 2, logn - 2, plan);
+        SplitRadix(data + 3 * n / 4, logn - 2, plan);
+
+        SplitRadixCombine(data, logn, 0, n / 4, plan);
+    }
+
+    // One radix 2 stage of the Stockham auto-sort FFT from src to dst. With l
+    // groups of m contiguous values (l * m = n / 2), for k < m:
+    //     dst[k + 2jm]     = src[k + jm] + src[k + jm + lm]
+    //     dst[k + 2jm + m] = twiddles[j] * (src[k + jm] - src[k + jm + lm])
+    // where twiddles[j] = exp(-+ 2 PI i j / 2l). All accesses are sequential.
+    // src is read with the given stride. Only the j in [j_first, j_last) are
+    // computed.
+    template < class InputIt, class OutputIt, class Float >
+    void StockhamStage(InputIt src, size_t src_stride, OutputIt dst, size_t l, size_t m,
+                       size_t j_first, size_t j_last, const std::complex<Float> *twiddles) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        constexpr bool use_simd = IsContiguous<InputIt>() && IsContiguous<OutputIt>()
+            && std::is_same<typename std::iterator_traits<InputIt>::value_type, ComplexType>::value
+            && std::is_same<ComplexType, std::complex<Float>>::value
+            && (std::is_same<Float, float>::value || std::is_same<Float, double>::value);
+
+        if constexpr (use_simd) {
+            if (src_stride == 1) {
+                simd::StockhamStage(&src[0], &dst[0], l, m, j_first, j_last, twiddles);
+                return;
+            }
+        }
+
+        const size_t half = l * m;
+        for (size_t j = j_first; j < j_last; j++) {
+            const ComplexType w = (ComplexType) twiddles[j];
+            for (size_t k = 0; k < m; k++) {
+                const ComplexType a = src[src_stride * (k + j * m)];
+                const ComplexType b = src[src_stride * (k + j * m + half)];
+                dst[k + 2 * j * m] = a + b;
+                dst[k + 2 * j * m + m] = MultiplyFinite(w, a - b);
+            }
+        }
+    }
+
+    // Radix R butterfly of the mixed radix engine: v[0...R) is replaced by its
+    // transform of length R. roots[j] = exp(-+ 2 PI i j / R) carries the
+    // direction of the transform.
+    template < int R, class ComplexType >
+    inline void MixedRadixButterfly(ComplexType *v, const ComplexType *roots) {
+        if constexpr (R == 2) {
+            const ComplexType a = v[0];
+            v[0] = a + v[1];
+            v[1] = a - v[1];
+        }
+        else if constexpr (R == 4) {
+            const ComplexType s02 = v[0] + v[2];
+            const ComplexType d02 = v[0] - v[2];
+            const ComplexType s13 = v[1] + v[3];
+            const ComplexType d13 = roots[1] * (v[1] - v[3]);
+            v[0] = s02 + s13;
+            v[1] = d02 + d13;
+            v[2] = s02 - s13;
+            v[3] = d02 - d13;
+        }
+        else {
+            // Odd prime: the terms j and R - j share their cosines and have
+            // opposite sines, so y_k and y_(R-k) are computed together from
+            //     sum_j = v_j + v_(R-j), diff_j = v_j - v_(R-j).
+            constexpr int H = (R - 1) / 2;
+
+            ComplexType sum[H], diff[H];
+            ComplexType y0 = v[0];
+            #pragma GCC unroll 3
+            for (int j = 1; j <= H; j++) {
+                sum[j - 1] = v[j] + v[R - j];
+                diff[j - 1] = v[j] - v[R - j];
+                y0 += sum[j - 1];
+            }
+
+            #pragma GCC unroll 3
+            for (int k = 1; k <= H; k++) {
+                ComplexType real_part = v[0];
+                ComplexType imag_part = 0;
+                #pragma GCC unroll 3
+                for (int j = 1; j <= H; j++) {
+                    const ComplexType w = roots[(j * k) % R];
+                    real_part += w.real() * sum[j - 1];
+                    imag_part += w.imag() * diff[j - 1];
+                }
+                // i * imag_part
+                const ComplexType rotated(-imag_part.imag(), imag_part.real());
+                v[k] = real_part + rotated;
+                v[R - k] = real_part - rotated;
+            }
+            v[0] = y0;
+        }
+    }
+
+    // Combination step of the mixed radix engine on data[0...n), which holds
+    // the R transforms of length m = n/R of the terms q, q + R, q + 2R, ...
+    // one after the other. Only the k in [k_first, k_last) are combined.
+    template < int R, class OutputIt, class Float >
+    void MixedRadixCombine(OutputIt data, size_t n, size_t k_first, size_t k_last,
+                           const MixedRadixPlan<Float> &plan) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const size_t m = n / R;
+        const size_t step = plan.Size() / n;
+        const auto roots = plan.Roots();
+
+        ComplexType butterfly_roots[R];
+        for (int j = 0; j < R; j++) {
+            butterfly_roots[j] = (ComplexType) roots[j * (plan.Size() / R)];
+        }
+
+        for (size_t k = k_first; k < k_last; k++) {
+            ComplexType v[R];
+            v[0] = data[k];
+            #pragma GCC unroll 7
+            for (int q = 1; q < R; q++) {
+                v[q] = (ComplexType) roots[q * k * step] * data[k + q * m];
+            }
+
+            MixedRadixButterfly<R>(v, butterfly_roots);
+
+            #pragma GCC unroll 7
+            for (int p = 0; p < R; p++) {
+                data[k + p * m] = v[p];
+            }
+        }
+    }
+
+    template < class OutputIt, class Float >
+    void MixedRadixCombine(OutputIt data, size_t n, int r, size_t k_first, size_t k_last,
+                           const MixedRadixPlan<Float> &plan) {
+        switch (r) {
+            case 2:
+                MixedRadixCombine<2>(data, n, k_first, k_last, plan);
+                break;
+            case 3:
+                MixedRadixCombine<3>(data, n, k_first, k_last, plan);
+                break;
+            case 4:
+                MixedRadixCombine<4>(data, n, k_first, k_last, plan);
+                break;
+            case 5:
+                MixedRadixCombine<5>(data, n, k_first, k_last, plan);
+                break;
+            case 7:
+                MixedRadixCombine<7>(data, n, k_first, k_last, plan);
+                break;
+            default:
+                assert(false);
+        }
+    }
+
+    // Decimation in time over the radices of the plan from index level on.
+    // The input of length n is read from first with the given stride.
+    template < class InputIt, class OutputIt, class Float >
+    void MixedRadix(InputIt first, OutputIt d_first, size_t stride, size_t n, size_t level,
+                    const MixedRadixPlan<Float> &plan) {
+        if (n == 1) {
+            d_first[0] = first[0];
+            return;
+        }
+
+        const int r = plan.Radices()[level];
+        const size_t m = n / r;
+        if (m == 1) {
+            // Last level: the sub-transforms of length 1 are plain copies.
+            for (int q = 0; q < r; q++) {
+                d_first[q] = first[q * stride];
+            }
+        }
+        else {
+            for (int q = 0; q < r; q++) {
+                MixedRadix(first + q * stride, d_first + q * m, stride * r, m, level + 1, plan);
+            }
+        }
+
+        MixedRadixCombine(d_first, n, r, 0, m, plan);
+    }
+
     template < class InputIt, class OutputIt, class Impl >
     struct Wrapper {
 
         void call(InputIt first, InputIt last, OutputIt d_first, bool is_inverse_transform) {
+            call_impl(first, last, d_first, is_inverse_transform, is_inverse_transform);
+        }
+
+        // Plan is one of the plan classes (FftPlan, FourStepPlan, ...).
+        template < class Plan >
+        void call(InputIt first, InputIt last, OutputIt d_first, const Plan &plan) {
+            assert((size_t) std::distance(first, last) == plan.Size());
+            call_impl(first, last, d_first, plan.IsInverse(), plan);
+        }
+
+    private:
+        // impl_args are forwarded to Impl after the stride: either the
+        // direction of the transform or a precomputed plan.
+        template < class... ImplArgs >
+        void call_impl(InputIt first, InputIt last, OutputIt d_first, bool is_inverse_transform,
+                       const ImplArgs&... impl_args) {
 
             const bool condition = IsMemEqual(first, d_first);
             const size_t N = std::distance(first, last);
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
 
             if (!condition) {
-                Impl{}.template operator()<InputIt, OutputIt>(first, last, d_first, 1, is_inverse_transform);
-            }
-            else {
-                std::vector<ComplexType> storage(N);
-                Impl{}.template operator()<InputIt, typename std::vector<ComplexType>::iterator>(first, last, storage.begin(), 1, is_inverse_transform);
-                std::copy(storage.begin(), storage.end(), d_first);
+                Impl{}.template operator()<InputIt, OutputIt>(first, last, d_first, 1, impl_args...);
+                if (is_inverse_transform) {
+                    std::for_each(d_first, d_first + N, [N](ComplexType& value){ value /= (ComplexType) N; });
+                }
+                return;
             }
 
+            // The copy back from the scratch buffer also normalizes.
+            std::vector<ComplexType> storage(N);
+            Impl{}.template operator()<InputIt, typename std::vector<ComplexType>::iterator>(first, last, storage.begin(), 1, impl_args...);
             if (is_inverse_transform) {
-                std::for_each(d_first, d_first + N, [N](ComplexType& value){ value /= (ComplexType) N; });
+                std::transform(storage.begin(), storage.end(), d_first, [N](const ComplexType& value){ return value / (ComplexType) N; });
+            } else {
+                std::copy(storage.begin(), storage.end(), d_first);
             }
         }
     };
@@ -56,12 +605,13 @@ namespace base_dft {
         void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
                         bool is_inverse_transform) {
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
 
             const size_t N = std::distance(first, last);
             const size_t n = 1 + (N - 1)/stride;
 
             for (size_t k = 0; k < n; k++) {
-                ComplexType twiddle = (ComplexType) fft_utils::RootOfUnity(n, is_inverse_transform ? k : -((int) k));
+                ComplexType twiddle = fft_utils::PreciseRootOfUnity<Float>(n, is_inverse_transform ? (long long) k : -((long long) k));
 
                 d_first[k] = (ComplexType) 0;
                 ComplexType twiddle_factor = (ComplexType) 1; 
@@ -89,6 +639,37 @@ namespace base_dft {
     } 
 }; // namespace base_dft
 
+// Transforms of the power of 2 sizes up to fft_codelets::CODELET_MAX_SIZE,
+// each a single unrolled codelet without any table. A size known at compile
+// time can also call fft_codelets::Codelet<N, IsInverse>::Run directly.
+namespace codelet_fft {
+
+    struct ImplDFT {
+        template < class InputIt, class OutputIt >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform) {
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(fft_utils::IsPowerOfTwo(n) && n <= fft_codelets::CODELET_MAX_SIZE);
+
+            fft_codelets::RunCodelet(fft_utils::IntLog2(n), is_inverse_transform, first, stride, d_first);
+        }
+    };
+
+    template < class InputIt, class OutputIt >
+    void DFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, false);
+    }
+
+    template < class InputIt, class OutputIt >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, true);
+    } 
+}; // namespace codelet_fft
+
 namespace recursive_fft {
     // Implementation inspired by pseudocode in
     // https://en.wikipedia.org/wiki/Cooley%E2%80%93Tukey_FFT_algorithm
@@ -99,41 +680,71 @@ namespace recursive_fft {
                         bool is_inverse_transform) {
             
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            if (n <= RECURSIVE_FFT_BASE_CASE_SIZE) {
+                assert(fft_utils::IsPowerOfTwo(n));
+                fft_codelets::RunCodelet(fft_utils::IntLog2(n), is_inverse_transform, first, stride, d_first);
+                return;
+            }
+
+            const FftPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan);
+        }
+
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan) {
 
             const size_t N = std::distance(first, last);
             const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
 
             if (n <= RECURSIVE_FFT_BASE_CASE_SIZE) {
-                base_dft::ImplDFT{}.template operator()<InputIt, OutputIt>(first, last, d_first, stride, is_inverse_transform);
+                fft_codelets::RunCodelet(plan.LogSize(), plan.IsInverse(), first, stride, d_first);
                 return;
             }
 
-            if (n % 2 != 0) {
-                std::cout << n << std::endl;
+            Recurse(first, d_first, stride, plan.LogSize(), plan);
+        }
+
+    private:
+        // The parallel engine finishes its small sub-transforms here
+        friend struct ImplParallelDFT;
+
+        template < class InputIt, class OutputIt, class Float >
+        void Recurse(InputIt first, OutputIt d_first, size_t stride, int logn,
+                     const FftPlan<Float> &plan) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+
+            if (logn <= fft_codelets::CODELET_LEAF_LOG_SIZE) {
+                fft_codelets::RunCodelet(logn, plan.IsInverse(), first, stride, d_first);
+                return;
             }
-            assert(n % 2 == 0);
+
+            const size_t n = size_t{1} << logn;
 
             // Even terms 0, 2*stride, 4*stride,...
-            this->template operator()<InputIt, OutputIt>(first, last, d_first, 2*stride, is_inverse_transform);
+            Recurse(first, d_first, 2*stride, logn - 1, plan);
 
             // Odd terms 1*stride, 3*stride, ...
-            this->template operator()<InputIt, OutputIt>(first + stride, last, d_first + n/2, 2*stride, is_inverse_transform);
+            Recurse(first + stride, d_first + n/2, 2*stride, logn - 1, plan);
 
-            // exp(2PI i/n) if IDFT
-            // else exp(-2PI i/n)
-            ComplexType root_of_unity = (ComplexType) fft_utils::RootOfUnity(n, is_inverse_transform ? 1 : -1);
-            ComplexType twiddle = (ComplexType) 1;
+            // twiddles[k] = exp(2PI i k/n) if IDFT
+            // else exp(-2PI i k/n)
+            const auto twiddles = plan.StageTwiddles(logn);
 
             for (size_t k = 0; k < n/2; k++) {
                 ComplexType p = d_first[k];
-                ComplexType q = twiddle * d_first[k + n/2];
+                ComplexType q = (ComplexType) twiddles[k] * d_first[k + n/2];
                 d_first[k] = p + q;
                 d_first[k + n/2] = p - q;
-
-                // twiddle = root_of_unity^(k+1) after next line
-                twiddle *= root_of_unity;
             }
-        } 
+        }
     };
 
     template < class InputIt, class OutputIt >
@@ -147,6 +758,20 @@ namespace recursive_fft {
         dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
         wrapper.call(first, last, d_first, true);
     } 
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    } 
 }; // namespace recursive_fft
 
 namespace iterative_fft {
@@ -159,55 +784,1200 @@ namespace iterative_fft {
                         bool is_inverse_transform) {
             
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
 
             const size_t N = std::distance(first, last);
-
             const size_t n = 1 + (N - 1)/stride;
-            const size_t logn = fft_utils::IntLog2(n);
 
-            for (size_t i = 0; i < n; i++) {
-                // Reverse the logN bits in the index.
-                size_t rev = fft_utils::ReverseBits(i, logn);
+            const FftPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan);
+        }
 
-                // Base case: set the output to the bit-reversed input.
-                d_first[i] = first[stride * rev];
-            }
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan) {
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan, (Float) 1);
+        }
 
-            int transform_sign = is_inverse_transform ? -1 : 1;
-            // Loop over 2, 4, 8, 16, ..., n
-            for (size_t s = 1; s <= logn; s++) {
-                // twiddle = exp(-2 PI i / 2^s)
-                ComplexType twiddle = (ComplexType) fft_utils::RootOfUnity(fft_utils::PowerOfTwo(s), -transform_sign);
+        // Transform multiplied by scale. With stride 1 the output may be the
+        // input, and the transform then runs in place without any buffer.
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan, Float scale) {
 
-                // Iterate through out in strides of length m=2**s
-                // Set k to 0, 2^s, 2 * 2^s, 3 * 2^s, ..., N-2^s
-                for (size_t k = 0; k < n; k += fft_utils::PowerOfTwo(s)) {
-                    ComplexType twiddle_factor = (ComplexType) 1;
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            const int logn = plan.LogSize();
+            assert(n == plan.Size());
 
-                    for (size_t j = 0; j < (size_t) fft_utils::PowerOfTwo(s-1); j++) {
-                        ComplexType a = d_first[k + j];
-                        ComplexType b = twiddle_factor * d_first[k + j + fft_utils::PowerOfTwo(s-1)];
-                        d_first[k + j] = a + b;
-                        d_first[k + j + fft_utils::PowerOfTwo(s-1)] = a - b;
+            const bool in_place = dft_detail::IsMemEqual(first, d_first);
+            assert(!in_place || stride == 1);
 
-                        twiddle_factor *= twiddle;
+            if (plan.Decomposition() == FftDecomposition::kSplitRadix) {
+                // Base case: set the output to the bit-reversed input.
+                if (stride == 1) {
+                    fft_utils::BitReversalPermutation(first, first + n, d_first);
+                }
+                else {
+                    for (size_t i = 0; i < n; i++) {
+                        d_first[i] = first[stride * plan.BitReversedIndex(i)];
                     }
                 }
+
+                dft_detail::SplitRadix(d_first, logn, plan);
+                dft_detail::Scale(d_first, n, scale);
+                return;
+            }
+
+            constexpr int leaf_log = fft_codelets::CODELET_LEAF_LOG_SIZE;
+
+            // In place, the bit reversal runs first and the codelets read their
+            // input in bit reversed order.
+            if (in_place) {
+                fft_utils::BitReversalPermutation(d_first, d_first + n, d_first);
+                if (logn <= fft_codelets::CODELET_MAX_LOG_SIZE) {
+                    fft_codelets::RunBitReversedCodelet(logn, plan.IsInverse(), d_first);
+                    dft_detail::Scale(d_first, n, scale);
+                    return;
+                }
+                dft_detail::BitReversedLeaves(d_first, leaf_log, 0, n >> leaf_log, plan.IsInverse(), scale);
+                dft_detail::RadixPasses(d_first, n, leaf_log + 1, plan);
+                return;
+            }
+
+            if (logn <= fft_codelets::CODELET_MAX_LOG_SIZE) {
+                fft_codelets::RunCodelet(logn, plan.IsInverse(), first, stride, d_first);
+                dft_detail::Scale(d_first, n, scale);
+                return;
             }
+
+            // Codelets of length L = 2^CODELET_LEAF_LOG_SIZE take the place of
+            // the bit reversal and of the stages with blocks of length 2, ..., L.
+            // The passes cover the stages with blocks of length 2L, ..., n.
+            dft_detail::CodeletLeaves(first, stride, d_first, logn, leaf_log, 0, n >> leaf_log, plan.IsInverse(), scale);
+            dft_detail::RadixPasses(d_first, n, leaf_log + 1, plan);
         }
     }; 
 
+    // The engine runs in place calls itself and fuses the normalization of
+    // the inverse transform into its first pass, so these functions do not go
+    // through dft_detail::Wrapper and allocate nothing but the plan.
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        ImplDFT{}(first, last, d_first, 1, plan, (Float) 1);
+    }
+
+    /// With FftNormalization::kNone the result is not divided by N.
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan,
+              FftNormalization normalization = FftNormalization::kByN) {
+        assert(plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        const Float scale = (normalization == FftNormalization::kByN) ? (Float) 1 / (Float) plan.Size() : (Float) 1;
+        ImplDFT{}(first, last, d_first, 1, plan, scale);
+    }
+
     template < class InputIt, class OutputIt >
     void DFT(InputIt first, InputIt last, OutputIt d_first) {
-        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
-        wrapper.call(first, last, d_first, false);
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using Float = typename ComplexType::value_type;
+
+        const FftPlan<Float> plan(std::distance(first, last), false);
+        DFT(first, last, d_first, plan);
     }
 
     template < class InputIt, class OutputIt >
     void IDFT(InputIt first, InputIt last, OutputIt d_first) {
-        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
-        wrapper.call(first, last, d_first, true);
-    } 
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using Float = typename ComplexType::value_type;
+
+        const FftPlan<Float> plan(std::distance(first, last), true);
+        IDFT(first, last, d_first, plan);
+    }
 }; // namespace iterative_fft
 
+// Stockham auto-sort FFT: the stages ping-pong between the output and a
+// scratch buffer, so the result comes out in natural order without a bit
+// reversal pass.
+namespace stockham_fft {
+
+    struct ImplDFT {
+        template < class InputIt, class OutputIt >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const FftPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan);
+        }
+
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            const int logn = plan.LogSize();
+            assert(n == plan.Size());
+
+            if (logn == 0) {
+                d_first[0] = first[0];
+                return;
+            }
+
+            std::vector<ComplexType> scratch(n);
+
+            // Stage t has l = n / 2^(t+1) groups of m = 2^t values and uses the
+            // twiddles of blocks of length 2l.
+            const auto stage = [&](auto src, size_t src_stride, auto dst, int t) {
+                const size_t m = size_t{1} << t;
+                const size_t l = n / (2 * m);
+                dft_detail::StockhamStage(src, src_stride, dst, l, m, 0, l, plan.StageTwiddles(logn - t));
+            };
+
+            // The first stage writes to the buffer that makes the last stage
+            // land in d_first.
+            bool in_output = (logn % 2 == 1);
+            if (in_output) {
+                stage(first, stride, d_first, 0);
+            } else {
+                stage(first, stride, scratch.begin(), 0);
+            }
+
+            for (int t = 1; t < logn; t++) {
+                if (in_output) {
+                    stage(d_first, 1, scratch.begin(), t);
+                } else {
+                    stage(scratch.begin(), 1, d_first, t);
+                }
+                in_output = !in_output;
+            }
+        }
+    };
+
+    template < class InputIt, class OutputIt >
+    void DFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, false);
+    }
+
+    template < class InputIt, class OutputIt >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, true);
+    } 
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    } 
+}; // namespace stockham_fft
+
+namespace dft_detail {
+    // One pass of the four step engine over the rows [row_first, row_last) of
+    // the matrix at src: each row is transformed into the same row of dst.
+    // The first pass transforms rows of length Columns() and multiplies entry
+    // (j, k) by the twiddle of index j * k; the second pass transforms rows of
+    // length Rows(). The rows fit in cache and go through the iterative
+    // engine, which transforms one row into another without any buffer.
+    template < class InputIt, class OutputIt, class Float >
+    void FourStepRows(InputIt src, OutputIt dst, size_t row_first, size_t row_last,
+                      const FourStepPlan<Float> &plan, bool is_first_pass) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const FftPlan<Float> &row_plan = is_first_pass ? plan.RowPlan() : plan.ColumnPlan();
+        const size_t length = row_plan.Size();
+
+        for (size_t j = row_first; j < row_last; j++) {
+            iterative_fft::ImplDFT{}(src + j * length, src + (j + 1) * length, dst + j * length, 1, row_plan);
+
+            if (is_first_pass) {
+                for (size_t k = 0; k < length; k++) {
+                    dst[j * length + k] = MultiplyFinite(dst[j * length + k], (ComplexType) plan.Twiddle(j * k));
+                }
+            }
+        }
+    }
+}; // namespace dft_detail
+
+// Four step (six step) FFT for transforms that do not fit in cache, see
+// FourStepPlan. With N = R * C, j = j1 + R * j2 and k = k2 + C * k1:
+//     1. transpose the input, seen as a C x R matrix, into A (R x C)
+//     2. transform the rows of A and multiply A[j1][k2] by w^(j1 k2)
+//     3. transpose A into B (C x R)
+//     4. transform the rows of B
+//     5. transpose B into the output (R x C)
+// The transposes are cache blocked and the row transforms fit in cache, so
+// the whole array is streamed a constant number of times instead of once
+// per stage.
+namespace four_step_fft {
+
+    struct ImplDFT {
+        template < class InputIt, class OutputIt >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const FourStepPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan);
+        }
+
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FourStepPlan<Float> &plan) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
+
+            const size_t rows = plan.Rows();
+            const size_t columns = plan.Columns();
+            std::vector<ComplexType> scratch(n);
+
+            fft_utils::BlockedTranspose(first, d_first, columns, rows, 0, columns, stride);
+            dft_detail::FourStepRows(d_first, scratch.begin(), 0, rows, plan, true);
+            fft_utils::BlockedTranspose(scratch.begin(), d_first, rows, columns, 0, rows);
+            dft_detail::FourStepRows(d_first, scratch.begin(), 0, columns, plan, false);
+            fft_utils::BlockedTranspose(scratch.begin(), d_first, columns, rows, 0, columns);
+        }
+    };
+
+    template < class InputIt, class OutputIt >
+    void DFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, false);
+    }
+
+    template < class InputIt, class OutputIt >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, true);
+    } 
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const FourStepPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const FourStepPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    } 
+}; // namespace four_step_fft
+
+// Mixed radix Cooley-Tukey for sizes whose only prime factors are 2, 3, 5
+// and 7, see MixedRadixPlan.
+namespace mixed_radix_fft {
+
+    struct ImplDFT {
+        template < class InputIt, class OutputIt >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const MixedRadixPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan);
+        }
+
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const MixedRadixPlan<Float> &plan) {
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
+
+            dft_detail::MixedRadix(first, d_first, stride, n, 0, plan);
+        }
+    };
+
+    template < class InputIt, class OutputIt >
+    void DFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, false);
+    }
+
+    template < class InputIt, class OutputIt >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, true);
+    } 
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const MixedRadixPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const MixedRadixPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    } 
+}; // namespace mixed_radix_fft
+
+/// BluesteinPlan
+/// Precomputed tables for transforms of any length n with Bluestein's (chirp-z)
+/// algorithm. With w_k = exp(-+ PI i k^2 / n) and km = (k^2 + m^2 - (k-m)^2) / 2,
+///     X_k = w_k * sum_m (x_m * w_m) * conj(w_{k-m}),
+/// a convolution that is computed with power of 2 transforms of length
+/// M >= 2n - 1. The plan holds the chirp w, the spectrum of conj(w) and the
+/// plans of the length M transforms. When n is a power of 2 the transform is
+/// computed directly by the iterative engine.
+template < class Float = FloatType >
+class BluesteinPlan {
+public:
+    using ComplexType = std::complex<Float>;
+
+    BluesteinPlan(const size_t size, const bool is_inverse_transform)
+        : m_size(size), m_is_inverse(is_inverse_transform),
+          m_convolution_size(ConvolutionSizeFor(size)) {
+
+        // A power of 2 only needs the plan of its own direction
+        if (IsPowerOfTwo()) {
+            if (m_is_inverse) {
+                m_inverse_plan.emplace(m_convolution_size, true);
+            } else {
+                m_forward_plan.emplace(m_convolution_size, false);
+            }
+            return;
+        }
+        m_forward_plan.emplace(m_convolution_size, false);
+        m_inverse_plan.emplace(m_convolution_size, true);
+
+        // k^2 mod 2n, updated with (k+1)^2 = k^2 + 2k + 1, keeps the angles
+        // exact for large k.
+        const int sign = m_is_inverse ? 1 : -1;
+        m_chirp.resize(m_size);
+        size_t k_squared = 0;
+        for (size_t k = 0; k < m_size; k++) {
+            m_chirp[k] = fft_utils::PreciseRootOfUnity<Float>(2 * m_size, sign * (long long) k_squared);
+            k_squared += 2 * k + 1;
+            while (k_squared >= 2 * m_size) {
+                k_squared -= 2 * m_size;
+            }
+        }
+
+        // conj(w_j) for -n < j < n, stored cyclically. The 1/M of the inverse
+        // convolution transform is folded into the spectrum.
+        std::vector<ComplexType> filter(m_convolution_size, (ComplexType) 0);
+        filter[0] = std::conj(m_chirp[0]);
+        for (size_t j = 1; j < m_size; j++) {
+            filter[j] = filter[m_convolution_size - j] = std::conj(m_chirp[j]);
+        }
+
+        m_filter_spectrum.resize(m_convolution_size);
+        iterative_fft::ImplDFT{}(filter.begin(), filter.end(), m_filter_spectrum.begin(), 1, *m_forward_plan);
+        for (auto &value : m_filter_spectrum) {
+            value /= (Float) m_convolution_size;
+        }
+    }
+
+    size_t Size() const { return m_size; }
+    bool IsInverse() const { return m_is_inverse; }
+
+    /// True when the transform skips the convolution and runs DirectPlan().
+    bool IsPowerOfTwo() const { return fft_utils::IsPowerOfTwo(m_size); }
+
+    /// Length M of the transforms of the convolution (n itself when n is a
+    /// power of 2).
+    size_t ConvolutionSize() const { return m_convolution_size; }
+
+    /// The plans of the convolution, for sizes that are not powers of 2.
+    const FftPlan<Float> &ForwardPlan() const { return *m_forward_plan; }
+    const FftPlan<Float> &InversePlan() const { return *m_inverse_plan; }
+
+    /// The plan of the transform itself, for powers of 2.
+    const FftPlan<Float> &DirectPlan() const { return m_is_inverse ? *m_inverse_plan : *m_forward_plan; }
+
+    /// w_k = exp(-+ PI i k^2 / n) for k < n.
+    const ComplexType *Chirp() const { return m_chirp.data(); }
+
+    /// Transform of length M of conj(w), divided by M.
+    const ComplexType *FilterSpectrum() const { return m_filter_spectrum.data(); }
+
+private:
+    static size_t ConvolutionSizeFor(const size_t size) {
+        // 2 * size - 1 would wrap around for size 0
+        assert(size > 0);
+        if (size == 0 || fft_utils::IsPowerOfTwo(size)) {
+            return size;
+        }
+        size_t convolution_size = 1;
+        while (convolution_size < 2 * size - 1) {
+            convolution_size <<= 1;
+        }
+        return convolution_size;
+    }
+
+    size_t m_size;
+    bool m_is_inverse;
+    size_t m_convolution_size;
+
+    std::optional<FftPlan<Float>> m_forward_plan;
+    std::optional<FftPlan<Float>> m_inverse_plan;
+
+    std::vector<ComplexType> m_chirp;
+    std::vector<ComplexType> m_filter_spectrum;
+};
+
+// Transforms of any length, see BluesteinPlan.
+namespace bluestein_fft {
+
+    struct ImplDFT {
+        template < class InputIt, class OutputIt >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const BluesteinPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan);
+        }
+
+        template < class InputIt, class OutputIt, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const BluesteinPlan<Float> &plan) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using PlanComplex = std::complex<Float>;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
+
+            if (plan.IsPowerOfTwo()) {
+                iterative_fft::ImplDFT{}.template operator()<InputIt, OutputIt>(first, last, d_first, stride, plan.DirectPlan());
+                return;
+            }
+
+            const size_t m = plan.ConvolutionSize();
+            const PlanComplex *chirp = plan.Chirp();
+            const PlanComplex *filter_spectrum = plan.FilterSpectrum();
+
+            // The convolution runs in the precision of the plan on contiguous
+            // buffers, so float and double go through the SIMD kernels.
+            std::vector<PlanComplex> signal(m, (PlanComplex) 0);
+            std::vector<PlanComplex> spectrum(m);
+
+            for (size_t k = 0; k < n; k++) {
+                signal[k] = chirp[k] * (PlanComplex) first[stride * k];
+            }
+
+            iterative_fft::ImplDFT{}(signal.begin(), signal.end(), spectrum.begin(), 1, plan.ForwardPlan());
+            for (size_t k = 0; k < m; k++) {
+                spectrum[k] *= filter_spectrum[k];
+            }
+            iterative_fft::ImplDFT{}(spectrum.begin(), spectrum.end(), signal.begin(), 1, plan.InversePlan());
+
+            for (size_t k = 0; k < n; k++) {
+                d_first[k] = (ComplexType) (chirp[k] * signal[k]);
+            }
+        }
+    };
+
+    template < class InputIt, class OutputIt >
+    void DFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, false);
+    }
+
+    template < class InputIt, class OutputIt >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first) {
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, true);
+    } 
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const BluesteinPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const BluesteinPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        dft_detail::Wrapper<InputIt, OutputIt, ImplDFT> wrapper;
+        wrapper.call(first, last, d_first, plan);
+    } 
+}; // namespace bluestein_fft
+
+/// RealFftPlan
+/// Plan of the transform of a real signal x of length n to the n / 2 + 1
+/// coefficients X_0, ..., X_{n/2} of its spectrum, the others following from
+/// X_{n-k} = conj(X_k). For even n the signal is packed into the complex
+/// signal z_m = x_{2m} + i x_{2m+1} of length h = n / 2, and with Z its
+/// transform and w = exp(-+ 2 PI i / n),
+///     X_k = (Z_k + conj(Z_{h-k})) / 2 - i w^k (Z_k - conj(Z_{h-k})) / 2,
+/// so the transform costs about half of a complex one. Odd lengths run a
+/// complex transform of length n.
+///
+/// The complex transform uses the mixed radix engine for lengths with prime
+/// factors 2, 3, 5 and 7 that are not powers of 2, and BluesteinPlan, which
+/// runs powers of 2 on the iterative engine, otherwise.
+template < class Float = FloatType >
+class RealFftPlan {
+public:
+    using ComplexType = std::complex<Float>;
+
+    RealFftPlan(const size_t size, const bool is_inverse_transform)
+        : m_size(size), m_is_inverse(is_inverse_transform),
+          m_complex_size(size % 2 == 0 ? size / 2 : size) {
+
+        assert(size > 0);
+
+        if (fft_utils::IsSmooth(m_complex_size) && !fft_utils::IsPowerOfTwo(m_complex_size)) {
+            m_mixed_radix_plan.emplace(m_complex_size, is_inverse_transform);
+        } else {
+            m_bluestein_plan.emplace(m_complex_size, is_inverse_transform);
+        }
+
+        if (!IsPacked()) {
+            return;
+        }
+
+        // w^k for k <= h/2: the coefficients k and h - k are computed together.
+        const int sign = m_is_inverse ? 1 : -1;
+        m_twiddles.resize(m_complex_size / 2 + 1);
+        for (size_t k = 0; k < m_twiddles.size(); k++) {
+            m_twiddles[k] = fft_utils::PreciseRootOfUnity<Float>(m_size, sign * (long long) k);
+        }
+    }
+
+    /// Length n of the real signal.
+    size_t Size() const { return m_size; }
+    bool IsInverse() const { return m_is_inverse; }
+
+    /// Number n / 2 + 1 of coefficients of the half spectrum.
+    size_t SpectrumSize() const { return m_size / 2 + 1; }
+
+    /// True when the signal is packed into a transform of half the length,
+    /// that is when n is even.
+    bool IsPacked() const { return m_size % 2 == 0; }
+
+    /// Length of the complex transform: n / 2 when IsPacked(), n otherwise.
+    size_t ComplexSize() const { return m_complex_size; }
+
+    /// Plan of the complex transform. UsesMixedRadix() tells which one is
+    /// built.
+    bool UsesMixedRadix() const { return m_mixed_radix_plan.has_value(); }
+    const MixedRadixPlan<Float> &MixedRadixComplexPlan() const { return *m_mixed_radix_plan; }
+    const BluesteinPlan<Float> &BluesteinComplexPlan() const { return *m_bluestein_plan; }
+
+    /// w^k = exp(-+ 2 PI i k / n) for k <= ComplexSize() / 2. Empty unless
+    /// IsPacked().
+    const ComplexType *Twiddles() const { return m_twiddles.data(); }
+
+private:
+    size_t m_size;
+    bool m_is_inverse;
+    size_t m_complex_size;
+
+    std::optional<MixedRadixPlan<Float>> m_mixed_radix_plan;
+    std::optional<BluesteinPlan<Float>> m_bluestein_plan;
+
+    std::vector<ComplexType> m_twiddles;
+};
+
+namespace dft_detail {
+    // Complex transform of the plan, from src[0...ComplexSize()) to dst, without
+    // normalization.
+    template < class Float >
+    void RealComplexTransform(std::complex<Float> *src, std::complex<Float> *dst, const RealFftPlan<Float> &plan) {
+        const size_t n = plan.ComplexSize();
+        if (plan.UsesMixedRadix()) {
+            mixed_radix_fft::ImplDFT{}(src, src + n, dst, 1, plan.MixedRadixComplexPlan());
+        } else {
+            bluestein_fft::ImplDFT{}(src, src + n, dst, 1, plan.BluesteinComplexPlan());
+        }
+    }
+
+    // The helpers below work on a range [i_first, i_last) of indices so that
+    // the parallel transforms can split them. PackReal and UnpackReal index the
+    // complex signal, i < ComplexSize(). SplitSpectrum and MergeSpectrum index
+    // the pairs of coefficients (k, ComplexSize() - k), k <= ComplexSize() / 2.
+
+    // Real signal to the complex signal of the plan.
+    template < class InputIt, class Float >
+    void PackReal(InputIt first, std::complex<Float> *packed, const RealFftPlan<Float> &plan,
+                  size_t i_first, size_t i_last) {
+        if (plan.IsPacked()) {
+            for (size_t m = i_first; m < i_last; m++) {
+                packed[m] = std::complex<Float>((Float) first[2 * m], (Float) first[2 * m + 1]);
+            }
+        } else {
+            for (size_t m = i_first; m < i_last; m++) {
+                packed[m] = (Float) first[m];
+            }
+        }
+    }
+
+    // Transform Z of the packed signal to the half spectrum X, see RealFftPlan.
+    // With E = (Z_k + conj(Z_{h-k})) / 2 and O = -i (Z_k - conj(Z_{h-k})) / 2,
+    //     X_k = E + w^k O    and    X_{h-k} = conj(E - w^k O).
+    // Every pair is read before it is written, so spectrum may be d_first.
+    template < class Float, class OutputIt >
+    void SplitSpectrum(const std::complex<Float> *spectrum, OutputIt d_first, const RealFftPlan<Float> &plan,
+                       size_t k_first, size_t k_last) {
+
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using PlanComplex = std::complex<Float>;
+
+        const size_t h = plan.ComplexSize();
+
+        if (!plan.IsPacked()) {
+            for (size_t k = k_first; k < k_last; k++) {
+                d_first[k] = (ComplexType) spectrum[k];
+            }
+            return;
+        }
+
+        const PlanComplex *twiddles = plan.Twiddles();
+        for (size_t k = k_first; k < k_last; k++) {
+            if (k == 0) {
+                const PlanComplex z = spectrum[0];
+                d_first[0] = (ComplexType) (z.real() + z.imag());
+                d_first[h] = (ComplexType) (z.real() - z.imag());
+                continue;
+            }
+
+            const PlanComplex a = spectrum[k];
+            const PlanComplex b = std::conj(spectrum[h - k]);
+            const PlanComplex even = (Float) 0.5 * (a + b);
+            const PlanComplex odd = MultiplyFinite(twiddles[k], PlanComplex((Float) 0.5 * (a.imag() - b.imag()), (Float) -0.5 * (a.real() - b.real())));
+
+            d_first[k] = (ComplexType) (even + odd);
+            d_first[h - k] = (ComplexType) std::conj(even - odd);
+        }
+    }
+
+    // Inverse of SplitSpectrum: the half spectrum X to the transform Z of the
+    // packed signal,
+    //     Z_k = E + i w^k D    and    Z_{h-k} = conj(E - i w^k D)
+    // with E = (X_k + conj(X_{h-k})) / 2, D = (X_k - conj(X_{h-k})) / 2 and the
+    // twiddles of the inverse plan. The imaginary parts of X_0 and X_{n/2},
+    // which are 0 for a real signal, are ignored.
+    template < class InputIt, class Float >
+    void MergeSpectrum(InputIt first, std::complex<Float> *spectrum, const RealFftPlan<Float> &plan,
+                       size_t k_first, size_t k_last) {
+
+        using PlanComplex = std::complex<Float>;
+
+        const size_t h = plan.ComplexSize();
+
+        if (!plan.IsPacked()) {
+            for (size_t k = k_first; k < k_last; k++) {
+                const PlanComplex value = (PlanComplex) first[k];
+                if (k == 0) {
+                    spectrum[0] = value.real();
+                } else {
+                    spectrum[k] = value;
+                    spectrum[h - k] = std::conj(value);
+                }
+            }
+            return;
+        }
+
+        const PlanComplex *twiddles = plan.Twiddles();
+        for (size_t k = k_first; k < k_last; k++) {
+            if (k == 0) {
+                const Float x_first = ((PlanComplex) first[0]).real();
+                const Float x_last = ((PlanComplex) first[h]).real();
+                spectrum[0] = PlanComplex((Float) 0.5 * (x_first + x_last), (Float) 0.5 * (x_first - x_last));
+                continue;
+            }
+
+            const PlanComplex a = (PlanComplex) first[k];
+            const PlanComplex b = std::conj((PlanComplex) first[h - k]);
+            const PlanComplex even = (Float) 0.5 * (a + b);
+            const PlanComplex odd = MultiplyFinite(twiddles[k], (Float) 0.5 * (a - b));
+            const PlanComplex i_odd(-odd.imag(), odd.real());
+
+            spectrum[k] = even + i_odd;
+            spectrum[h - k] = std::conj(even - i_odd);
+        }
+    }
+
+    // Buffer of RFFT for the transform of the packed signal. For even lengths
+    // it fits in the output, which then avoids a copy when it is contiguous in
+    // the precision of the plan: SplitSpectrum runs in place.
+    template < class OutputIt, class Float >
+    std::complex<Float> *RealSpectrumBuffer(OutputIt d_first, const RealFftPlan<Float> &plan,
+                                            std::vector<std::complex<Float>> &storage) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        if constexpr (IsContiguous<OutputIt>() && std::is_same<ComplexType, std::complex<Float>>::value) {
+            if (plan.IsPacked()) {
+                return &(*d_first);
+            }
+        }
+        storage.resize(plan.ComplexSize());
+        return storage.data();
+    }
+
+    // Complex signal of the plan, normalized, to the real signal.
+    template < class Float, class OutputIt >
+    void UnpackReal(const std::complex<Float> *packed, OutputIt d_first, const RealFftPlan<Float> &plan,
+                    size_t i_first, size_t i_last) {
+
+        using RealType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const Float scale = (Float) 1 / (Float) plan.ComplexSize();
+        if (plan.IsPacked()) {
+            for (size_t m = i_first; m < i_last; m++) {
+                d_first[2 * m] = (RealType) (scale * packed[m].real());
+                d_first[2 * m + 1] = (RealType) (scale * packed[m].imag());
+            }
+        } else {
+            for (size_t m = i_first; m < i_last; m++) {
+                d_first[m] = (RealType) (scale * packed[m].real());
+            }
+        }
+    }
+}; // namespace dft_detail
+
+// Transforms of real signals, see RealFftPlan. RFFT writes the n / 2 + 1
+// coefficients of the half spectrum and IRFFT goes back from them to the n
+// real values, normalized like the other inverse transforms.
+namespace real_fft {
+
+    template < class InputIt, class OutputIt, class Float >
+    void RFFT(InputIt first, InputIt last, OutputIt d_first, const RealFftPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.Size());
+
+        const size_t h = plan.ComplexSize();
+        std::vector<std::complex<Float>> packed(h);
+        dft_detail::PackReal(first, packed.data(), plan, 0, h);
+
+        std::vector<std::complex<Float>> storage;
+        std::complex<Float> *spectrum = dft_detail::RealSpectrumBuffer(d_first, plan, storage);
+        dft_detail::RealComplexTransform(packed.data(), spectrum, plan);
+        dft_detail::SplitSpectrum(spectrum, d_first, plan, 0, h / 2 + 1);
+    }
+
+    /// [first, last) is the half spectrum of plan.SpectrumSize() coefficients.
+    template < class InputIt, class OutputIt, class Float >
+    void IRFFT(InputIt first, InputIt last, OutputIt d_first, const RealFftPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.SpectrumSize());
+
+        const size_t h = plan.ComplexSize();
+        std::vector<std::complex<Float>> spectrum(h), packed(h);
+
+        dft_detail::MergeSpectrum(first, spectrum.data(), plan, 0, h / 2 + 1);
+        dft_detail::RealComplexTransform(spectrum.data(), packed.data(), plan);
+        dft_detail::UnpackReal(packed.data(), d_first, plan, 0, h);
+    }
+
+    template < class InputIt, class OutputIt >
+    void RFFT(InputIt first, InputIt last, OutputIt d_first) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using Float = typename ComplexType::value_type;
+
+        const RealFftPlan<Float> plan(std::distance(first, last), false);
+        RFFT(first, last, d_first, plan);
+    }
+
+    /// Without a plan the signal has the even length 2 * (last - first - 1);
+    /// odd lengths need a plan.
+    template < class InputIt, class OutputIt >
+    void IRFFT(InputIt first, InputIt last, OutputIt d_first) {
+        using Float = typename std::iterator_traits<OutputIt>::value_type;
+
+        const RealFftPlan<Float> plan(2 * (std::distance(first, last) - 1), true);
+        IRFFT(first, last, d_first, plan);
+    }
+}; // namespace real_fft
+
+/// BatchLayout
+/// Memory layout of a batch of signals of the same length n. Element i of
+/// signal b is read at first[b * input_distance + i * input_stride] and
+/// coefficient k of its transform is written at
+/// d_first[b * output_distance + k]. The output either coincides with the input
+/// (equal distances, unit stride) or does not overlap it.
+struct BatchLayout {
+    size_t batch_size;
+    size_t input_stride;
+    size_t input_distance;
+    size_t output_distance;
+
+    /// Signals stored one after the other.
+    static BatchLayout Contiguous(const size_t batch_size, const size_t size) {
+        return BatchLayout{batch_size, 1, size, size};
+    }
+};
+
+namespace dft_detail {
+    // Small float and double signals are transformed up to
+    // BATCH_INTERLEAVE_MAX_WIDTH at a time, as many as fit in
+    // BATCH_INTERLEAVE_BYTES with their scratch buffer (about a third of L1).
+    // Larger groups spill out of L1 and are slower than one signal at a time.
+    constexpr size_t BATCH_INTERLEAVE_MAX_WIDTH = 8;
+    constexpr size_t BATCH_INTERLEAVE_BYTES = size_t{1} << 14;
+
+    template < class ComplexType >
+    constexpr bool IsSimdComplex() {
+        return std::is_same<ComplexType, std::complex<float>>::value
+            || std::is_same<ComplexType, std::complex<double>>::value;
+    }
+
+    // Transforms the signals [b_first, b_last) of a batch, all with the same
+    // plan. The inverse transforms are normalized.
+    //
+    // Small float and double signals are interleaved, width at a time:
+    // element i of lane r is stored at buffer[i * width + r]. A Stockham stage
+    // with groups of m * width values is then the same stage on every lane,
+    // so the SIMD kernels work on full vectors even in the first stages, where
+    // a single signal has groups of 1 or 2 values. Other signals go one by one
+    // through the iterative engine. The scratch memory is allocated once per
+    // call.
+    template < class InputIt, class OutputIt, class Float >
+    void BatchRange(InputIt first, OutputIt d_first, const BatchLayout &layout,
+                    size_t b_first, size_t b_last, const FftPlan<Float> &plan) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const size_t n = plan.Size();
+        const int logn = plan.LogSize();
+        const size_t input_span = (n - 1) * layout.input_stride + 1;
+        const Float scale = plan.IsInverse() ? (Float) 1 / (Float) n : (Float) 1;
+
+        const size_t width = std::min(BATCH_INTERLEAVE_MAX_WIDTH, BATCH_INTERLEAVE_BYTES / (2 * n * sizeof(ComplexType)));
+        const bool interleave = IsSimdComplex<ComplexType>() && std::is_same<ComplexType, std::complex<Float>>::value
+            && width > 1 && b_last - b_first > 1;
+
+        if (!interleave) {
+            // A signal transformed in place has a unit stride, which the
+            // iterative engine handles without a buffer.
+            for (size_t b = b_first; b < b_last; b++) {
+                const InputIt src = first + b * layout.input_distance;
+                const OutputIt dst = d_first + b * layout.output_distance;
+                iterative_fft::ImplDFT{}.template operator()<InputIt, OutputIt>(src, src + input_span, dst, layout.input_stride, plan, scale);
+            }
+            return;
+        }
+
+        std::vector<ComplexType> buffer(n * width);
+        std::vector<ComplexType> scratch(n * width);
+
+        for (size_t b = b_first; b < b_last; b += width) {
+            // The last group may have fewer signals. Its unused lanes are
+            // transformed too, so that every group of the stages keeps a
+            // power of 2 length.
+            const size_t count = std::min(width, b_last - b);
+
+            for (size_t r = 0; r < count; r++) {
+                const InputIt src = first + (b + r) * layout.input_distance;
+                for (size_t i = 0; i < n; i++) {
+                    buffer[i * width + r] = src[i * layout.input_stride];
+                }
+            }
+
+            ComplexType *src = buffer.data();
+            ComplexType *dst = scratch.data();
+            for (int t = 0; t < logn; t++) {
+                const size_t m = size_t{1} << t;
+                const size_t l = n / (2 * m);
+                StockhamStage(src, 1, dst, l, m * width, 0, l, plan.StageTwiddles(logn - t));
+                std::swap(src, dst);
+            }
+
+            for (size_t r = 0; r < count; r++) {
+                const OutputIt out = d_first + (b + r) * layout.output_distance;
+                for (size_t i = 0; i < n; i++) {
+                    out[i] = src[i * width + r] * scale;
+                }
+            }
+        }
+    }
+}; // namespace dft_detail
+
+// Batches of transforms of the same power of 2 length sharing one plan, see
+// BatchLayout and dft_detail::BatchRange.
+namespace batched_fft {
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(const BatchLayout &layout, InputIt first, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(!plan.IsInverse());
+        dft_detail::BatchRange(first, d_first, layout, 0, layout.batch_size, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(const BatchLayout &layout, InputIt first, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(plan.IsInverse());
+        dft_detail::BatchRange(first, d_first, layout, 0, layout.batch_size, plan);
+    }
+
+    /// Contiguous batch: [first, last) holds signals of length plan.Size()
+    /// one after the other.
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(std::distance(first, last) % plan.Size() == 0);
+        DFT(BatchLayout::Contiguous(std::distance(first, last) / plan.Size(), plan.Size()), first, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan) {
+        assert(std::distance(first, last) % plan.Size() == 0);
+        IDFT(BatchLayout::Contiguous(std::distance(first, last) / plan.Size(), plan.Size()), first, d_first, plan);
+    }
+}; // namespace batched_fft
+
+namespace dft_detail {
+    // Transforms along one axis of a row-major array seen as outer blocks of
+    // length x inner values, for the blocks [o_first, o_last). Each block is
+    // transposed into scratch, where the transforms are contiguous rows of a
+    // batch, and transposed back. scratch holds length * inner values.
+    template < class It, class Float >
+    void MultiDimAxisBlocks(It data, size_t length, size_t inner, size_t o_first, size_t o_last,
+                            const FftPlan<Float> &plan, std::vector<typename std::iterator_traits<It>::value_type> &scratch) {
+        const BatchLayout layout = BatchLayout::Contiguous(inner, length);
+
+        for (size_t o = o_first; o < o_last; o++) {
+            const It block = data + o * length * inner;
+            fft_utils::BlockedTranspose(block, scratch.begin(), length, inner, 0, length);
+            BatchRange(scratch.begin(), scratch.begin(), layout, 0, inner, plan);
+            fft_utils::BlockedTranspose(scratch.begin(), block, inner, length, 0, inner);
+        }
+    }
+
+    // Transforms the array at data, of the given shape, in place along every
+    // axis but the last one. An axis followed by axes of length 1 is
+    // contiguous and needs no transpose.
+    template < class It, class Float >
+    void MultiDimAxes(It data, const std::vector<size_t> &shape, const MultiDimPlan<Float> &plan) {
+        using ComplexType = typename std::iterator_traits<It>::value_type;
+
+        const int rank = shape.size();
+        std::vector<ComplexType> scratch;
+
+        for (int axis = 0; axis + 1 < rank; axis++) {
+            size_t outer = 1, inner = 1;
+            for (int a = 0; a < axis; a++) {
+                outer *= shape[a];
+            }
+            for (int a = axis + 1; a < rank; a++) {
+                inner *= shape[a];
+            }
+
+            if (inner == 1) {
+                BatchRange(data, data, BatchLayout::Contiguous(outer, shape[axis]), 0, outer, plan.AxisPlan(axis));
+            }
+            else {
+                scratch.resize(shape[axis] * inner);
+                MultiDimAxisBlocks(data, shape[axis], inner, 0, outer, plan.AxisPlan(axis), scratch);
+            }
+        }
+    }
+
+    // Complex transform of every axis: the contiguous rows of the last axis
+    // from first to d_first, then the other axes in place.
+    template < class InputIt, class OutputIt, class Float >
+    void MultiDim(InputIt first, OutputIt d_first, const MultiDimPlan<Float> &plan) {
+        const size_t n = plan.Shape().back();
+        const size_t rows = plan.Size() / n;
+
+        BatchRange(first, d_first, BatchLayout::Contiguous(rows, n), 0, rows, plan.AxisPlan(plan.Rank() - 1));
+        MultiDimAxes(d_first, plan.Shape(), plan);
+    }
+
+    // Real input: the rows 2p and 2p + 1 of length n are packed into the
+    // complex row x + i y, for the pairs [p_first, p_last). A missing last row
+    // is taken as zero.
+    template < class InputIt, class ComplexType >
+    void PairRealRows(InputIt first, ComplexType *packed, size_t rows, size_t n, size_t p_first, size_t p_last) {
+        using Float = typename ComplexType::value_type;
+
+        for (size_t p = p_first; p < p_last; p++) {
+            const InputIt x = first + 2 * p * n;
+            ComplexType *z = packed + p * n;
+            if (2 * p + 1 < rows) {
+                for (size_t i = 0; i < n; i++) {
+                    z[i] = ComplexType((Float) x[i], (Float) x[n + i]);
+                }
+            }
+            else {
+                for (size_t i = 0; i < n; i++) {
+                    z[i] = ComplexType((Float) x[i], 0);
+                }
+            }
+        }
+    }
+
+    // Splits the transform Z of a packed pair into the half spectra of its rows,
+    // of length n / 2 + 1, with
+    //     X_k = (Z_k + conj(Z_{n-k})) / 2,    Y_k = -i (Z_k - conj(Z_{n-k})) / 2.
+    template < class ComplexType, class OutputIt >
+    void UnpairSpectra(const ComplexType *packed, OutputIt d_first, size_t rows, size_t n, size_t p_first, size_t p_last) {
+        using Float = typename ComplexType::value_type;
+
+        const size_t h = n / 2 + 1;
+        for (size_t p = p_first; p < p_last; p++) {
+            const ComplexType *z = packed + p * n;
+            const OutputIt x = d_first + 2 * p * h;
+            const bool has_pair = 2 * p + 1 < rows;
+            for (size_t k = 0; k < h; k++) {
+                const ComplexType a = z[k];
+                const ComplexType b = std::conj(z[(n - k) & (n - 1)]);
+                x[k] = (a + b) * (Float) 0.5;
+                if (has_pair) {
+                    const ComplexType d = (a - b) * (Float) 0.5;
+                    x[h + k] = ComplexType(d.imag(), -d.real());
+                }
+            }
+        }
+    }
+
+    // Inverse of UnpairSpectra: packs the half spectra X and Y of the rows
+    // 2p and 2p + 1 into Z = X + i Y over the full length n. The imaginary
+    // parts of X_0, X_{n/2}, Y_0 and Y_{n/2} are those of real rows, zero.
+    template < class InputIt, class ComplexType >
+    void PairHalfSpectra(InputIt first, ComplexType *packed, size_t rows, size_t n, size_t p_first, size_t p_last) {
+        const size_t h = n / 2 + 1;
+        for (size_t p = p_first; p < p_last; p++) {
+            const InputIt x = first + 2 * p * h;
+            ComplexType *z = packed + p * n;
+            const bool has_pair = 2 * p + 1 < rows;
+            for (size_t k = 0; k < h; k++) {
+                ComplexType a = x[k];
+                ComplexType b = has_pair ? (ComplexType) x[h + k] : ComplexType(0);
+                if (k == 0 || 2 * k == n) {
+                    a = ComplexType(a.real(), 0);
+                    b = ComplexType(b.real(), 0);
+                }
+                z[k] = ComplexType(a.real() - b.imag(), a.imag() + b.real());
+                if (k > 0 && 2 * k < n) {
+                    z[n - k] = ComplexType(a.real() + b.imag(), b.real() - a.imag());
+                }
+            }
+        }
+    }
+
+    // Inverse of PairRealRows.
+    template < class ComplexType, class OutputIt >
+    void UnpairRealRows(const ComplexType *packed, OutputIt d_first, size_t rows, size_t n, size_t p_first, size_t p_last) {
+        for (size_t p = p_first; p < p_last; p++) {
+            const ComplexType *z = packed + p * n;
+            const OutputIt x = d_first + 2 * p * n;
+            const bool has_pair = 2 * p + 1 < rows;
+            for (size_t i = 0; i < n; i++) {
+                x[i] = z[i].real();
+                if (has_pair) {
+                    x[n + i] = z[i].imag();
+                }
+            }
+        }
+    }
+}; // namespace dft_detail
+
+// Multidimensional transforms of row-major arrays, see MultiDimPlan. The axes
+// are transformed one after the other, the last one first: its rows are
+// contiguous and go through the batched engine. Along every other axis the
+// array is a sequence of length x inner matrices, transposed with cache blocked
+// transposes so that the transforms become contiguous rows too.
+//
+// Real input transforms pack two real rows into one complex row, so the real
+// axis costs half of a complex one, and run the other axes on the half
+// spectrum.
+namespace multidim_fft {
+
+    template < class InputIt, class OutputIt, class Float >
+    void DFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan) {
+        assert(!plan.IsInverse() && !plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        dft_detail::MultiDim(first, d_first, plan);
+    }
+
+    template < class InputIt, class OutputIt, class Float >
+    void IDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan) {
+        assert(plan.IsInverse() && !plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        dft_detail::MultiDim(first, d_first, plan);
+    }
+
+    /// Real signal [first, last) of shape plan.Shape() to its half spectrum
+    /// at d_first, of shape plan.SpectrumShape().
+    template < class InputIt, class OutputIt, class Float >
+    void RealDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan) {
+        assert(!plan.IsInverse() && plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.Size());
+
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const size_t n = plan.Shape().back();
+        const size_t rows = plan.Size() / n;
+        const size_t pairs = (rows + 1) / 2;
+
+        std::vector<ComplexType> packed(pairs * n);
+        dft_detail::PairRealRows(first, packed.data(), rows, n, 0, pairs);
+        dft_detail::BatchRange(packed.begin(), packed.begin(), BatchLayout::Contiguous(pairs, n), 0, pairs, plan.AxisPlan(plan.Rank() - 1));
+        dft_detail::UnpairSpectra(packed.data(), d_first, rows, n, 0, pairs);
+
+        dft_detail::MultiDimAxes(d_first, plan.SpectrumShape(), plan);
+    }
+
+    /// Half spectrum [first, last) of shape plan.SpectrumShape() to the real
+    /// signal at d_first, of shape plan.Shape(). The input is left unchanged.
+    template < class InputIt, class OutputIt, class Float >
+    void RealIDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan) {
+        assert(plan.IsInverse() && plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.SpectrumSize());
+
+        using ComplexType = typename std::iterator_traits<InputIt>::value_type;
+
+        const size_t n = plan.Shape().back();
+        const size_t rows = plan.Size() / n;
+        const size_t pairs = (rows + 1) / 2;
+
+        std::vector<ComplexType> spectrum(first, last);
+        dft_detail::MultiDimAxes(spectrum.begin(), plan.SpectrumShape(), plan);
+
+        std::vector<ComplexType> packed(pairs * n);
+        dft_detail::PairHalfSpectra(spectrum.begin(), packed.data(), rows, n, 0, pairs);
+        dft_detail::BatchRange(packed.begin(), packed.begin(), BatchLayout::Contiguous(pairs, n), 0, pairs, plan.AxisPlan(plan.Rank() - 1));
+        dft_detail::UnpairRealRows(packed.data(), d_first, rows, n, 0, pairs);
+    }
+}; // namespace multidim_fft
+
 #endif
\ No newline at end of file
@@ -0,0 +1,192 @@
+#pragma once
+
+#ifndef CORE_FFT_CODELETS_H
+#define CORE_FFT_CODELETS_H
+
+#include <complex>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+// The codelets only pay off once the whole template tree is inlined into
+// straight-line code, which the default inlining limits of -O2 stop short of.
+#if defined(__GNUC__)
+#define FFT_CODELET_INLINE __attribute__((always_inline)) inline
+#else
+#define FFT_CODELET_INLINE inline
+#endif
+
+/// Fully unrolled transforms of the power of 2 sizes 1, 2, ..., 64, with
+/// compile-time twiddles. Codelet<N, IsInverse> is generated by templates:
+/// two codelets of size N/2 on the even and odd terms followed by N/2
+/// butterflies. The twiddles 1 and -+i cost no multiplication.
+///
+/// They are the leaves of the recursive and iterative engines, where the
+/// loops of the last levels are too short to pay for their overhead and for
+/// the twiddle loads.
+namespace fft_codelets {
+
+    constexpr int CODELET_MAX_LOG_SIZE = 6;
+    constexpr size_t CODELET_MAX_SIZE = size_t{1} << CODELET_MAX_LOG_SIZE;
+
+    // Size of the leaves of larger transforms. Bigger codelets no longer fit
+    // in the registers and are slower per point; a transform of at most
+    // CODELET_MAX_SIZE points still runs as a single codelet.
+    constexpr int CODELET_LEAF_LOG_SIZE = 4;
+
+    struct ConstexprComplex {
+        long double real;
+        long double imag;
+    };
+
+    // cos(x) and sin(x) for |x| <= PI / 2 with their Taylor series.
+    constexpr ConstexprComplex TaylorCosSin(const long double x) {
+        long double cos_term = 1, sin_term = x;
+        long double cos_sum = 1, sin_sum = x;
+        for (int n = 1; n < 30; n++) {
+            cos_term *= -x * x / ((2 * n - 1) * (2 * n));
+            sin_term *= -x * x / ((2 * n) * (2 * n + 1));
+            cos_sum += cos_term;
+            sin_sum += sin_term;
+        }
+        return ConstexprComplex{cos_sum, sin_sum};
+    }
+
+    // exp(-+ 2 PI i k / N) at compile time. The quadrant of the angle is
+    // taken exactly with integers, so the roots on the axes are exact.
+    constexpr ConstexprComplex ConstexprRootOfUnity(const size_t N, const size_t k, const bool is_inverse_transform) {
+        const long double pi = 3.141592653589793238462643383279502884L;
+
+        const size_t m = k % N;
+        const size_t quadrant = 4 * m / N;
+        const size_t remainder = 4 * m - quadrant * N;
+        const ConstexprComplex r = TaylorCosSin(pi / 2 * remainder / N);
+
+        ConstexprComplex root = r;
+        if (quadrant == 1) {
+            root = ConstexprComplex{-r.imag, r.real};
+        } else if (quadrant == 2) {
+            root = ConstexprComplex{-r.real, -r.imag};
+        } else if (quadrant == 3) {
+            root = ConstexprComplex{r.imag, -r.real};
+        }
+
+        return is_inverse_transform ? root : ConstexprComplex{root.real, -root.imag};
+    }
+
+    /// Codelet<N, IsInverse>::Run(first, stride, d_first) writes to
+    /// d_first[0...N) the transform of first[0], first[stride], ...,
+    /// first[(N-1) * stride], in the precision of d_first.
+    template < size_t N, bool IsInverse >
+    struct Codelet {
+        static_assert(N >= 2 && (N & (N - 1)) == 0 && N <= CODELET_MAX_SIZE, "N must be a power of 2 up to 64");
+
+        template < class InputIt, class OutputIt >
+        static FFT_CODELET_INLINE void Run(InputIt first, size_t stride, OutputIt d_first) {
+            Codelet<N / 2, IsInverse>::Run(first, 2 * stride, d_first);
+            Codelet<N / 2, IsInverse>::Run(first + stride, 2 * stride, d_first + N / 2);
+            Combine(d_first, std::make_index_sequence<N / 2>{});
+        }
+
+        /// In place transform of data[0...N) stored in bit reversed order, as
+        /// left by the bit reversal of the iterative engine: the even terms are
+        /// then the first half of the data and the odd terms the second half.
+        template < class It >
+        static FFT_CODELET_INLINE void RunBitReversed(It data) {
+            Codelet<N / 2, IsInverse>::RunBitReversed(data);
+            Codelet<N / 2, IsInverse>::RunBitReversed(data + N / 2);
+            Combine(data, std::make_index_sequence<N / 2>{});
+        }
+
+    private:
+        template < class OutputIt, size_t... K >
+        static FFT_CODELET_INLINE void Combine(OutputIt d_first, std::index_sequence<K...>) {
+            (Butterfly<K>(d_first), ...);
+        }
+
+        template < size_t K, class OutputIt >
+        static FFT_CODELET_INLINE void Butterfly(OutputIt d_first) {
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+            using Float = typename ComplexType::value_type;
+
+            const ComplexType a = d_first[K];
+            const ComplexType b = d_first[K + N / 2];
+
+            ComplexType q;
+            if constexpr (K == 0) {
+                q = b;
+            }
+            else if constexpr (4 * K == N) {
+                q = IsInverse ? ComplexType(-b.imag(), b.real()) : ComplexType(b.imag(), -b.real());
+            }
+            else {
+                constexpr ConstexprComplex w = ConstexprRootOfUnity(N, K, IsInverse);
+                constexpr Float c = (Float) w.real;
+                constexpr Float s = (Float) w.imag;
+                q = ComplexType(c * b.real() - s * b.imag(), c * b.imag() + s * b.real());
+            }
+
+            d_first[K] = a + q;
+            d_first[K + N / 2] = a - q;
+        }
+    };
+
+    template < bool IsInverse >
+    struct Codelet<1, IsInverse> {
+        template < class InputIt, class OutputIt >
+        static FFT_CODELET_INLINE void Run(InputIt first, size_t, OutputIt d_first) {
+            d_first[0] = first[0];
+        }
+
+        template < class It >
+        static FFT_CODELET_INLINE void RunBitReversed(It) {}
+    };
+
+    /// Runs the codelet of size 2^logn, for logn <= CODELET_MAX_LOG_SIZE.
+    template < bool IsInverse, class InputIt, class OutputIt >
+    inline void RunCodelet(int logn, InputIt first, size_t stride, OutputIt d_first) {
+        switch (logn) {
+            case 0: Codelet<1, IsInverse>::Run(first, stride, d_first); break;
+            case 1: Codelet<2, IsInverse>::Run(first, stride, d_first); break;
+            case 2: Codelet<4, IsInverse>::Run(first, stride, d_first); break;
+            case 3: Codelet<8, IsInverse>::Run(first, stride, d_first); break;
+            case 4: Codelet<16, IsInverse>::Run(first, stride, d_first); break;
+            case 5: Codelet<32, IsInverse>::Run(first, stride, d_first); break;
+            case 6: Codelet<64, IsInverse>::Run(first, stride, d_first); break;
+        }
+    }
+
+    template < class InputIt, class OutputIt >
+    inline void RunCodelet(int logn, bool is_inverse_transform, InputIt first, size_t stride, OutputIt d_first) {
+        if (is_inverse_transform) {
+            RunCodelet<true>(logn, first, stride, d_first);
+        } else {
+            RunCodelet<false>(logn, first, stride, d_first);
+        }
+    }
+
+    /// Runs Codelet<2^logn>::RunBitReversed, for logn <= CODELET_MAX_LOG_SIZE.
+    template < bool IsInverse, class It >
+    inline void RunBitReversedCodelet(int logn, It data) {
+        switch (logn) {
+            case 0: break;
+            case 1: Codelet<2, IsInverse>::RunBitReversed(data); break;
+            case 2: Codelet<4, IsInverse>::RunBitReversed(data); break;
+            case 3: Codelet<8, IsInverse>::RunBitReversed(data); break;
+            case 4: Codelet<16, IsInverse>::RunBitReversed(data); break;
+            case 5: Codelet<32, IsInverse>::RunBitReversed(data); break;
+            case 6: Codelet<64, IsInverse>::RunBitReversed(data); break;
+        }
+    }
+
+    template < class It >
+    inline void RunBitReversedCodelet(int logn, bool is_inverse_transform, It data) {
+        if (is_inverse_transform) {
+            RunBitReversedCodelet<true>(logn, data);
+        } else {
+            RunBitReversedCodelet<false>(logn, data);
+        }
+    }
+}; // namespace fft_codelets
+
+#endif
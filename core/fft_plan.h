@@ -0,0 +1,293 @@
+#pragma once
+
+#ifndef CORE_FFT_PLAN_H
+#define CORE_FFT_PLAN_H
+
+#include <vector>
+#include <cassert>
+
+#include <core/fft_types.h>
+#include <core/fft_utils.h>
+
+/// Stage decomposition used by the iterative engine.
+/// kRadix4 and kRadix8 run 2 and 3 radix 2 stages at once as radix 4 and radix
+/// 8 butterflies: one pass over memory, and R - 1 twiddle products per column
+/// of R values instead of log2(R) * R / 2.
+/// kSplitRadix runs the split radix algorithm on the bit reversed input.
+enum class FftDecomposition {
+    kRadix2,
+    kRadix4,
+    kRadix8,
+    kSplitRadix,
+};
+
+/// Scaling of the inverse transforms of the iterative engine. kByN divides by
+/// N, so that the inverse undoes the forward transform. kNone skips it, for
+/// callers that fold 1/N into a pass of their own (a pointwise product, ...).
+enum class FftNormalization {
+    kByN,
+    kNone,
+};
+
+/// FftPlan
+/// Precomputed tables for power of 2 transforms of a fixed size, direction and
+/// precision. Building a plan costs O(N); the engines that take a plan only do
+/// table lookups afterwards, so a plan should be reused across transforms.
+template < class Float = FloatType >
+class FftPlan {
+public:
+    using ComplexType = std::complex<Float>;
+
+    FftPlan(const size_t size, const bool is_inverse_transform,
+            const FftDecomposition decomposition = FftDecomposition::kRadix2)
+        : m_size(size), m_log_size(fft_utils::IntLog2(size)), m_is_inverse(is_inverse_transform),
+          m_decomposition(decomposition) {
+
+        assert(fft_utils::IsPowerOfTwo(size));
+
+        // The passes with fewer stages go first, where the blocks are small.
+        if (m_decomposition != FftDecomposition::kSplitRadix) {
+            const int radix_log = (m_decomposition == FftDecomposition::kRadix8) ? 3
+                                : (m_decomposition == FftDecomposition::kRadix4) ? 2 : 1;
+            if (m_log_size % radix_log != 0) {
+                m_passes.push_back(m_log_size % radix_log);
+            }
+            for (int s = 0; s < m_log_size / radix_log; s++) {
+                m_passes.push_back(radix_log);
+            }
+        }
+
+        // The last stage holds exp(-+ 2 PI i j / N) for j < N/2. Every other stage
+        // is a subsample of it. Stage s (half length 2^(s-1)) is stored at
+        // offset 2^(s-1) - 1.
+        m_twiddles.resize(m_size > 1 ? m_size - 1 : 0);
+        if (m_log_size == 0) {
+            return;
+        }
+
+        const size_t half_size = m_size / 2;
+        const int sign = m_is_inverse ? 1 : -1;
+        ComplexType *last_stage = m_twiddles.data() + (half_size - 1);
+        for (size_t j = 0; j < half_size; j++) {
+            last_stage[j] = fft_utils::PreciseRootOfUnity<Float>(m_size, sign * (long long) j);
+        }
+
+        for (int s = 1; s < m_log_size; s++) {
+            const size_t half = size_t{1} << (s - 1);
+            const size_t step = half_size / half;
+            ComplexType *stage = m_twiddles.data() + (half - 1);
+            for (size_t j = 0; j < half; j++) {
+                stage[j] = last_stage[j * step];
+            }
+        }
+    }
+
+    size_t Size() const { return m_size; }
+    int LogSize() const { return m_log_size; }
+    bool IsInverse() const { return m_is_inverse; }
+    FftDecomposition Decomposition() const { return m_decomposition; }
+
+    /// Number of radix 2 stages fused in each pass of the iterative engine, in
+    /// execution order. Empty for kSplitRadix.
+    const std::vector<int> &Passes() const { return m_passes; }
+
+    /// Index of the input element that lands at position i after the bit
+    /// reversal permutation.
+    size_t BitReversedIndex(const size_t i) const { return fft_utils::ReverseBits(i, m_log_size); }
+
+    /// Twiddles of stage s, for 1 <= s <= LogSize(). These are the 2^(s-1)
+    /// values exp(-+ 2 PI i j / 2^s) for j = 0, ..., 2^(s-1) - 1.
+    const ComplexType *StageTwiddles(const int s) const {
+        assert(s >= 1 && s <= m_log_size);
+        return m_twiddles.data() + ((size_t{1} << (s - 1)) - 1);
+    }
+
+private:
+    size_t m_size;
+    int m_log_size;
+    bool m_is_inverse;
+    FftDecomposition m_decomposition;
+
+    std::vector<int> m_passes;
+
+    std::vector<ComplexType> m_twiddles;
+};
+
+/// FourStepPlan
+/// Plan of the four step (six step) engine for power of 2 sizes. A transform
+/// of size N = Rows() * Columns() is computed with Rows() transforms of length
+/// Columns(), a twiddle multiplication and Columns() transforms of length
+/// Rows(), separated by transposes. Every sub-transform fits in cache.
+///
+/// The twiddles exp(-+ 2 PI i m / N), m < N, are the product of two tables
+/// of about sqrt(N) entries instead of a table of N entries.
+template < class Float = FloatType >
+class FourStepPlan {
+public:
+    using ComplexType = std::complex<Float>;
+
+    FourStepPlan(const size_t size, const bool is_inverse_transform)
+        : m_size(size), m_is_inverse(is_inverse_transform),
+          m_rows(size_t{1} << (fft_utils::IntLog2(size) / 2)), m_columns(size / m_rows),
+          m_row_plan(m_columns, is_inverse_transform), m_column_plan(m_rows, is_inverse_transform),
+          m_fine_log_size(fft_utils::IntLog2(m_columns)) {
+
+        assert(fft_utils::IsPowerOfTwo(size));
+
+        const int sign = m_is_inverse ? 1 : -1;
+        const size_t fine_size = size_t{1} << m_fine_log_size;
+        const size_t coarse_size = m_size / fine_size;
+
+        m_fine_twiddles.resize(fine_size);
+        for (size_t j = 0; j < fine_size; j++) {
+            m_fine_twiddles[j] = fft_utils::PreciseRootOfUnity<Float>(m_size, sign * (long long) j);
+        }
+        m_coarse_twiddles.resize(coarse_size);
+        for (size_t j = 0; j < coarse_size; j++) {
+            m_coarse_twiddles[j] = fft_utils::PreciseRootOfUnity<Float>(m_size, sign * (long long) (j * fine_size));
+        }
+    }
+
+    size_t Size() const { return m_size; }
+    bool IsInverse() const { return m_is_inverse; }
+
+    /// Number of transforms of length Columns() in the first pass.
+    size_t Rows() const { return m_rows; }
+    size_t Columns() const { return m_columns; }
+
+    /// Plans of the first pass (length Columns()) and of the second pass
+    /// (length Rows()).
+    const FftPlan<Float> &RowPlan() const { return m_row_plan; }
+    const FftPlan<Float> &ColumnPlan() const { return m_column_plan; }
+
+    /// exp(-+ 2 PI i m / N) for m < N.
+    ComplexType Twiddle(const size_t m) const {
+        const ComplexType a = m_coarse_twiddles[m >> m_fine_log_size];
+        const ComplexType b = m_fine_twiddles[m & ((size_t{1} << m_fine_log_size) - 1)];
+        return ComplexType(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+    }
+
+private:
+    size_t m_size;
+    bool m_is_inverse;
+
+    size_t m_rows;
+    size_t m_columns;
+
+    FftPlan<Float> m_row_plan;
+    FftPlan<Float> m_column_plan;
+
+    int m_fine_log_size;
+    std::vector<ComplexType> m_fine_twiddles;
+    std::vector<ComplexType> m_coarse_twiddles;
+};
+
+/// MixedRadixPlan
+/// Precomputed tables for the mixed radix engine, for sizes whose only prime
+/// factors are 2, 3, 5 and 7. The size is split into radices 7, 5, 3, 4 and 2,
+/// in this order from the outermost level of the recursion, and every twiddle
+/// is looked up in a single table of the N roots of unity.
+template < class Float = FloatType >
+class MixedRadixPlan {
+public:
+    using ComplexType = std::complex<Float>;
+
+    MixedRadixPlan(const size_t size, const bool is_inverse_transform)
+        : m_size(size), m_is_inverse(is_inverse_transform) {
+
+        assert(fft_utils::IsSmooth(size));
+
+        size_t rest = m_size;
+        for (int radix : {7, 5, 3, 4, 2}) {
+            while (rest % radix == 0) {
+                m_radices.push_back(radix);
+                rest /= radix;
+            }
+        }
+
+        const int sign = m_is_inverse ? 1 : -1;
+        m_roots.resize(m_size);
+        for (size_t j = 0; j < m_size; j++) {
+            m_roots[j] = fft_utils::PreciseRootOfUnity<Float>(m_size, sign * (long long) j);
+        }
+    }
+
+    size_t Size() const { return m_size; }
+    bool IsInverse() const { return m_is_inverse; }
+
+    /// Radix of every level of the recursion, outermost first. Their product
+    /// is Size().
+    const std::vector<int> &Radices() const { return m_radices; }
+
+    /// exp(-+ 2 PI i j / N) for j < N.
+    const ComplexType *Roots() const { return m_roots.data(); }
+
+private:
+    size_t m_size;
+    bool m_is_inverse;
+
+    std::vector<int> m_radices;
+    std::vector<ComplexType> m_roots;
+};
+
+/// MultiDimPlan
+/// Plan of a multidimensional transform, typically 2D or 3D, of a row-major
+/// array of the given shape: {rows, columns} or {planes, rows, columns}. Every
+/// axis has a power of 2 length and its own FftPlan.
+///
+/// With is_real_input the signal is real. The forward transform then only
+/// returns the half spectrum, of shape SpectrumShape() = {..., columns / 2 + 1},
+/// the rest following from the Hermitian symmetry, and the inverse transform
+/// goes back from it to the real signal.
+template < class Float = FloatType >
+class MultiDimPlan {
+public:
+    using ComplexType = std::complex<Float>;
+
+    MultiDimPlan(const std::vector<size_t> &shape, const bool is_inverse_transform, const bool is_real_input = false)
+        : m_shape(shape), m_spectrum_shape(shape),
+          m_is_inverse(is_inverse_transform), m_is_real_input(is_real_input) {
+
+        assert(!m_shape.empty());
+
+        for (size_t length : m_shape) {
+            m_axis_plans.emplace_back(length, is_inverse_transform);
+        }
+        if (m_is_real_input) {
+            m_spectrum_shape.back() = m_shape.back() / 2 + 1;
+        }
+    }
+
+    bool IsInverse() const { return m_is_inverse; }
+    bool IsRealInput() const { return m_is_real_input; }
+
+    int Rank() const { return m_shape.size(); }
+    const std::vector<size_t> &Shape() const { return m_shape; }
+    const std::vector<size_t> &SpectrumShape() const { return m_spectrum_shape; }
+
+    /// Number of values of the signal and of the spectrum. They differ only
+    /// for real input.
+    size_t Size() const { return Product(m_shape); }
+    size_t SpectrumSize() const { return Product(m_spectrum_shape); }
+
+    /// Plan of the transforms along the given axis, of length Shape()[axis].
+    const FftPlan<Float> &AxisPlan(const int axis) const { return m_axis_plans[axis]; }
+
+private:
+    static size_t Product(const std::vector<size_t> &shape) {
+        size_t product = 1;
+        for (size_t length : shape) {
+            product *= length;
+        }
+        return product;
+    }
+
+    std::vector<size_t> m_shape;
+    std::vector<size_t> m_spectrum_shape;
+    bool m_is_inverse;
+    bool m_is_real_input;
+
+    std::vector<FftPlan<Float>> m_axis_plans;
+};
+
+#endif
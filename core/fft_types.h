@@ -3,5 +3,12 @@
 #include <complex>
 #include <vector>
 
-#define FloatType long double
-#define Complex std::complex<FloatType>
+// The engines take their precision from the value type of the iterators, so
+// any of float, double and long double can be used. ComplexOf<Float> is the
+// matching complex type.
+template < class Float >
+using ComplexOf = std::complex<Float>;
+
+// Default precision of the non-templated helpers and of the command line tools.
+using FloatType = long double;
+using Complex = ComplexOf<FloatType>;
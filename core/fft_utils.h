@@ -4,6 +4,8 @@
 #include <cmath>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <vector>
 
 #include <core/fft_types.h>
 
@@ -12,6 +14,20 @@ namespace fft_utils {
         return ((bool) N) && !(bool) (N & (N-1));
     }
 
+    // True when the only prime factors of N are 2, 3, 5 and 7, the sizes the
+    // mixed radix engine handles.
+    inline bool IsSmooth(size_t N) {
+        if (N == 0) {
+            return false;
+        }
+        for (size_t p : {2, 3, 5, 7}) {
+            while (N % p == 0) {
+                N /= p;
+            }
+        }
+        return N == 1;
+    }
+
     inline int IntLog2(size_t N) {
         int output = -1;
         while (N != 0) {
@@ -25,36 +41,109 @@ namespace fft_utils {
         return (1 << N);
     }
 
+    // REVERSED_BYTES.value[b] is the byte b with its 8 bits reversed.
+    struct ReversedByteTable {
+        uint8_t value[256];
+
+        constexpr ReversedByteTable() : value() {
+            for (int b = 0; b < 256; b++) {
+                int reversed = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    reversed |= ((b >> bit) & 1) << (7 - bit);
+                }
+                value[b] = (uint8_t) reversed;
+            }
+        }
+    };
+
+    inline constexpr ReversedByteTable REVERSED_BYTES{};
+
     // Outputs a number that corresponds to the first (from least significant to
-    // most significant) n_bits of n reversed in binary.
-    inline int ReverseBits(int n, int n_bits) {
-        constexpr int max_n_bits = 31;
-
-        int n_reversed = 0;
-        for (int bit_idx=0; bit_idx < max_n_bits; bit_idx++) {
-            n_reversed <<= 1;
-            n_reversed |= (n & 1);
-            n >>= 1;
+    // most significant) n_bits of n reversed in binary. The bytes are reversed
+    // with a lookup table, one byte at a time.
+    inline size_t ReverseBits(size_t n, int n_bits) {
+        const int n_bytes = (n_bits + 7) / 8;
+
+        size_t n_reversed = 0;
+        for (int byte_idx = 0; byte_idx < n_bytes; byte_idx++) {
+            n_reversed = (n_reversed << 8) | REVERSED_BYTES.value[n & 0xFF];
+            n >>= 8;
         }
 
-        n_reversed >>= (max_n_bits - n_bits);
-        return n_reversed;
+        return n_reversed >> (8 * n_bytes - n_bits);
     }
 
-    // BitReversalPermutation permutes the values in [first...last] using the
-    // bit reversal permutation. It stores the output starting at d_first.
-    //  It is allowed that d_first == first.
-    // It is required that first, last, d_first are Random Access Iterators with
-    // std::distance(first, last) being a power of 2.
+    // log2 of the side of the tiles of BitReversalPermutation.
+    constexpr int BIT_REVERSAL_TILE_LOG_SIZE = 4;
+
+    // Blocks b in [b_first, b_last) of the cache blocked bit reversal
+    // permutation of a sequence of length 2^log_n (COBRA, Carter and Gatlin).
+    //
+    // An index is split as i = (a, b, c), with a and c the high and low
+    // q = BIT_REVERSAL_TILE_LOG_SIZE bits and b the middle bits. Its reverse
+    // is (rev(c), rev(b), rev(a)), so the 2^q x 2^q elements of block b all
+    // land in block rev(b). Blocks b and rev(b) are loaded in tiles (rows of
+    // 2^q contiguous elements), transposed in cache and stored crosswise, which
+    // also works in place. Only the b <= rev(b) of the range do any work.
     template < class InputIt, class OutputIt >
-    inline void BitReversalPermutation(InputIt first, InputIt last, OutputIt d_first) {
-        const int N = std::distance(first, last);
-        const int logN = IntLog2(N);
+    inline void BitReversalBlocks(InputIt first, OutputIt d_first, int log_n, size_t b_first, size_t b_last) {
+        using ValueType = typename std::iterator_traits<OutputIt>::value_type;
 
-        assert(IsPowerOfTwo(N));
+        constexpr int q = BIT_REVERSAL_TILE_LOG_SIZE;
+        constexpr size_t Q = size_t{1} << q;
+        const int m = log_n - 2 * q;
+        assert(m >= 0);
+
+        size_t reversed_tile_index[Q];
+        for (size_t a = 0; a < Q; a++) {
+            reversed_tile_index[a] = ReverseBits(a, q);
+        }
+
+        // On the stack, so that an in place permutation allocates nothing.
+        ValueType tiles[2 * Q * Q];
+
+        for (size_t b = b_first; b < b_last; b++) {
+            const size_t b_reversed = ReverseBits(b, m);
+            if (b_reversed < b) {
+                continue;
+            }
+
+            const size_t blocks[2] = {b, b_reversed};
+            const int num_blocks = (b == b_reversed) ? 1 : 2;
+
+            for (int t = 0; t < num_blocks; t++) {
+                ValueType *tile = tiles + t * Q * Q;
+                for (size_t a = 0; a < Q; a++) {
+                    const size_t src = (a << (m + q)) | (blocks[t] << q);
+                    ValueType *tile_row = tile + reversed_tile_index[a] * Q;
+                    for (size_t c = 0; c < Q; c++) {
+                        tile_row[c] = first[src | c];
+                    }
+                }
+            }
+
+            for (int t = 0; t < num_blocks; t++) {
+                const ValueType *tile = tiles + t * Q * Q;
+                const size_t dst_block = blocks[num_blocks - 1 - t];
+                for (size_t c = 0; c < Q; c++) {
+                    const size_t dst = (reversed_tile_index[c] << (m + q)) | (dst_block << q);
+                    for (size_t a = 0; a < Q; a++) {
+                        d_first[dst | a] = tile[a * Q + c];
+                    }
+                }
+            }
+        }
+    }
+
+    // Sequences shorter than a square of two tiles are permuted element by
+    // element.
+    template < class InputIt, class OutputIt >
+    inline void SmallBitReversalPermutation(InputIt first, OutputIt d_first, int log_n) {
+        const size_t N = size_t{1} << log_n;
+        const bool in_place = ((const void *) &(*first) == (const void *) &(*d_first));
 
-        for (int i = 0; i < N; i++) {
-            int j = fft_utils::ReverseBits(i, logN);
+        for (size_t i = 0; i < N; i++) {
+            const size_t j = ReverseBits(i, log_n);
 
             // Here we want to make d_first[i] = first[j] and d_first[j] = first[i]
             // The following code ensures that there are no problems if first==d_first
@@ -64,7 +153,7 @@ namespace fft_utils {
                 continue; 
             }
 
-            if (d_first == first) {
+            if (in_place) {
                 std::swap(d_first[i], d_first[j]);
             }
             else {
@@ -74,9 +163,103 @@ namespace fft_utils {
         }
     }
 
+    // BitReversalPermutation permutes the values in [first...last] using the
+    // bit reversal permutation. It stores the output starting at d_first.
+    //  It is allowed that d_first == first.
+    // It is required that first, last, d_first are Random Access Iterators with
+    // std::distance(first, last) being a power of 2.
+    template < class InputIt, class OutputIt >
+    inline void BitReversalPermutation(InputIt first, InputIt last, OutputIt d_first) {
+        const size_t N = std::distance(first, last);
+        const int logN = IntLog2(N);
+
+        assert(IsPowerOfTwo(N));
+
+        if (logN < 2 * BIT_REVERSAL_TILE_LOG_SIZE) {
+            SmallBitReversalPermutation(first, d_first, logN);
+            return;
+        }
+
+        BitReversalBlocks(first, d_first, logN, 0, size_t{1} << (logN - 2 * BIT_REVERSAL_TILE_LOG_SIZE));
+    }
+
+    // Parallel version of BitReversalPermutation: the blocks are split in
+    // chunks over parallelizer.parallel_for.
+    template < class InputIt, class OutputIt, class Parallelizer >
+    inline void ParallelBitReversalPermutation(InputIt first, InputIt last, OutputIt d_first,
+                                               const Parallelizer& parallelizer) {
+        const size_t N = std::distance(first, last);
+        const int logN = IntLog2(N);
+
+        assert(IsPowerOfTwo(N));
+
+        // 16 blocks of 256 elements per task
+        constexpr size_t chunk = 16;
+        const int m = logN - 2 * BIT_REVERSAL_TILE_LOG_SIZE;
+        if (m < 0 || (size_t{1} << m) <= chunk) {
+            BitReversalPermutation(first, last, d_first);
+            return;
+        }
+
+        const size_t num_blocks = size_t{1} << m;
+        const auto task = [&](size_t b_first, size_t b_last) {
+            BitReversalBlocks(first, d_first, logN, b_first, b_last);
+        };
+        parallelizer.parallel_for(0, num_blocks, chunk, task);
+    }
+
+    // Side of the tiles of BlockedTranspose. A 16x16 tile of long double
+    // complex numbers takes 8 KiB, so a source and a destination tile fit in L1.
+    constexpr size_t TRANSPOSE_BLOCK_SIZE = 16;
+
+    // Transposes the rows x cols matrix stored row-major at src (read with
+    // the given stride) into the cols x rows matrix at dst:
+    //     dst[c * rows + r] = src[stride * (r * cols + c)]
+    // Only the source rows in [row_first, row_last) are handled, so disjoint
+    // row ranges can run in parallel. The matrix is walked in square tiles to
+    // keep both sides in cache. src and dst must not overlap.
+    template < class InputIt, class OutputIt >
+    inline void BlockedTranspose(InputIt src, OutputIt dst, size_t rows, size_t cols,
+                                 size_t row_first, size_t row_last, size_t stride = 1) {
+        constexpr size_t B = TRANSPOSE_BLOCK_SIZE;
+
+        for (size_t r0 = row_first; r0 < row_last; r0 += B) {
+            const size_t r1 = std::min(r0 + B, row_last);
+            for (size_t c0 = 0; c0 < cols; c0 += B) {
+                const size_t c1 = std::min(c0 + B, cols);
+                for (size_t r = r0; r < r1; r++) {
+                    for (size_t c = c0; c < c1; c++) {
+                        dst[c * rows + r] = src[stride * (r * cols + c)];
+                    }
+                }
+            }
+        }
+    }
+
+    // Parallel version of BlockedTranspose: the source rows are split in bands
+    // of TRANSPOSE_BLOCK_SIZE over parallelizer.parallel_for.
+    template < class InputIt, class OutputIt, class Parallelizer >
+    inline void ParallelBlockedTranspose(InputIt src, OutputIt dst, size_t rows, size_t cols,
+                                         const Parallelizer& parallelizer, size_t stride = 1) {
+        const auto task = [&](size_t row_first, size_t row_last) {
+            BlockedTranspose(src, dst, rows, cols, row_first, row_last, stride);
+        };
+        parallelizer.parallel_for(0, rows, TRANSPOSE_BLOCK_SIZE, task);
+    }
+
     inline std::complex<double> RootOfUnity(int N, int k) {
         // Returns exp(i*2*pi*k/N)
         double theta = 2 * M_PI * k / (double) N;
         return std::complex<double> (cos(theta), sin(theta));
     }
+
+    // Returns exp(i*2*pi*k/N) computed in long double and rounded to Float.
+    // Used to build twiddle tables, where the error of every entry matters.
+    template < class Float >
+    inline std::complex<Float> PreciseRootOfUnity(size_t N, long long k) {
+        k %= (long long) N;
+        const long double pi = 3.141592653589793238462643383279502884L;
+        const long double theta = 2 * pi * k / (long double) N;
+        return std::complex<Float> ((Float) std::cos(theta), (Float) std::sin(theta));
+    }
 };
\ No newline at end of file
@@ -4,86 +4,318 @@
 
 #include <core/fft_types.h>
 #include <core/fft_utils.h>
+#include <core/async.h>
 
 #include <cassert>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 
+namespace modular_fft_detail {
+    /// Arithmetic modulo an odd p < 2^62 in Montgomery form, with R = 2^64:
+    /// x is represented by x R mod p. The product of two numbers is reduced
+    /// with two multiplications and a shift instead of a division by p.
+    ///
+    /// mul(a, b) = a b / R (mod p) is the product of Montgomery forms. A
+    /// number in Montgomery form times a number in normal form gives the
+    /// product in normal form, which is how the butterflies use it: the
+    /// twiddles are in Montgomery form and the data stays in normal form.
+    struct MontgomeryModulus {
+        uint64_t p;
+        // -p^-1 mod R
+        uint64_t p_neg_inverse;
+        // R^2 mod p
+        uint64_t r2;
+
+        explicit MontgomeryModulus(const uint64_t p) : p(p) {
+            assert(p % 2 == 1 && p < (uint64_t{1} << 62));
+
+            // p^-1 mod R by Newton's iteration. p p = 1 (mod 8) for odd p, so
+            // p is its own inverse on 3 bits, and each step doubles the bits.
+            uint64_t inverse = p;
+            for (int i = 0; i < 5; i++) {
+                inverse *= 2 - p * inverse;
+            }
+            p_neg_inverse = -inverse;
+
+            const uint64_t r = (-p) % p;
+            r2 = (uint64_t) ((unsigned __int128) r * r % p);
+        }
+
+        // t / R (mod p) for t < p R
+        uint64_t reduce(const unsigned __int128 t) const {
+            const uint64_t m = (uint64_t) t * p_neg_inverse;
+            const uint64_t reduced = (uint64_t) ((t + (unsigned __int128) m * p) >> 64);
+            return (reduced >= p) ? reduced - p : reduced;
+        }
+
+        uint64_t mul(const uint64_t a, const uint64_t b) const {
+            return reduce((unsigned __int128) a * b);
+        }
+
+        uint64_t to_montgomery(const uint64_t x) const {
+            return mul(x, r2);
+        }
+
+        uint64_t from_montgomery(const uint64_t x) const {
+            return reduce(x);
+        }
+
+        /// a b (mod p) for a and b in normal form.
+        uint64_t mul_mod(const uint64_t a, const uint64_t b) const {
+            return mul(mul(a, b), r2);
+        }
+
+        uint64_t add(const uint64_t a, const uint64_t b) const {
+            const uint64_t sum = a + b;
+            return (sum >= p) ? sum - p : sum;
+        }
+
+        uint64_t sub(const uint64_t a, const uint64_t b) const {
+            return (a >= b) ? a - b : a + p - b;
+        }
+
+        /// base^exponent (mod p) in normal form.
+        uint64_t pow(const uint64_t base, uint64_t exponent) const {
+            uint64_t result = to_montgomery(1);
+            uint64_t power = to_montgomery(base % p);
+            while (exponent > 0) {
+                if (exponent & 1) {
+                    result = mul(result, power);
+                }
+                power = mul(power, power);
+                exponent >>= 1;
+            }
+            return from_montgomery(result);
+        }
+    };
+}; // namespace modular_fft_detail
+
+/// Everything a transform of size N modulo the prime p needs besides the
+/// data: the Montgomery constants of p, the root g, the twiddles of every
+/// stage for both directions, in Montgomery form, and N^-1 mod p.
+///
+/// Building a plan costs a search for a primitive root and O(N) products.
+/// NttPlan::Cached shares the plans of a process, so that repeated
+/// transforms of the same size pay for it once.
+class NttPlan {
+public:
+    /// g must be a primitive root modulo p, and p === 1 (mod N).
+    NttPlan(const nt::Integer p, const size_t size, const nt::Integer g)
+        : m_modulus(p), m_prime(p), m_root(g), m_size(size), m_log_size(fft_utils::IntLog2(size)) {
+
+        assert(size == (size_t{1} << m_log_size));
+        assert(p % (nt::Integer) size == 1);
+
+        const modular_fft_detail::MontgomeryModulus &mod = m_modulus;
+
+        // omega^N === 1 (mod p) since k*N == p-1
+        const uint64_t omega = mod.pow(g, (p - 1) / (nt::Integer) size);
+        const uint64_t inverse_omega = mod.pow(omega, p - 2);
+
+        // The twiddles of stage s are powers of a 2^s root of unity, stored
+        // at offset 2^(s-1) - 1 as in FftPlan.
+        m_twiddles.resize(std::max<size_t>(size, 1) - 1);
+        m_inverse_twiddles.resize(std::max<size_t>(size, 1) - 1);
+        for (int s = 1; s <= m_log_size; s++) {
+            const size_t half = size_t{1} << (s - 1);
+            const uint64_t twiddle = mod.to_montgomery(mod.pow(omega, size_t{1} << (m_log_size - s)));
+            const uint64_t inverse_twiddle = mod.to_montgomery(mod.pow(inverse_omega, size_t{1} << (m_log_size - s)));
+
+            uint64_t *stage = m_twiddles.data() + (half - 1);
+            uint64_t *inverse_stage = m_inverse_twiddles.data() + (half - 1);
+            stage[0] = inverse_stage[0] = mod.to_montgomery(1);
+            for (size_t j = 1; j < half; j++) {
+                stage[j] = mod.mul(stage[j - 1], twiddle);
+                inverse_stage[j] = mod.mul(inverse_stage[j - 1], inverse_twiddle);
+            }
+        }
+
+        m_inverse_size = mod.to_montgomery(mod.pow(size, p - 2));
+    }
+
+    /// The plan of (p, N) with the primitive root nt::PrimitiveRootModPrime(p),
+    /// shared by all callers. Safe to call from several threads.
+    static std::shared_ptr<const NttPlan> Cached(const nt::Integer p, const size_t size) {
+        return Cached(p, size, DefaultRoot(p));
+    }
+
+    /// The plan of (p, N) with the root g, shared by all callers.
+    static std::shared_ptr<const NttPlan> Cached(const nt::Integer p, const size_t size, const nt::Integer g) {
+        if (auto plan = Lookup(p, size, g)) {
+            return plan;
+        }
+        return Store(std::make_shared<const NttPlan>(p, size, g));
+    }
+
+    size_t Size() const { return m_size; }
+    int LogSize() const { return m_log_size; }
+    nt::Integer Prime() const { return m_prime; }
+    nt::Integer Root() const { return m_root; }
+
+    const modular_fft_detail::MontgomeryModulus& Modulus() const { return m_modulus; }
+
+    /// The 2^(s-1) twiddles of stage s, in Montgomery form.
+    const uint64_t *StageTwiddles(const int s, const bool is_inverse_transform) const {
+        assert(s >= 1 && s <= m_log_size);
+        const size_t offset = (size_t{1} << (s - 1)) - 1;
+        return (is_inverse_transform ? m_inverse_twiddles.data() : m_twiddles.data()) + offset;
+    }
+
+    /// N^-1 mod p, in Montgomery form.
+    uint64_t InverseSize() const { return m_inverse_size; }
+
+private:
+    // (p, N, g)
+    using Key = std::tuple<nt::Integer, size_t, nt::Integer>;
+
+    struct Cache {
+        std::mutex mutex;
+        std::map<Key, std::shared_ptr<const NttPlan>> plans;
+        // The primitive root of each prime seen by Cached(p, N)
+        std::map<nt::Integer, nt::Integer> default_roots;
+    };
+
+    static Cache& GetCache() {
+        static Cache cache;
+        return cache;
+    }
+
+    static nt::Integer DefaultRoot(const nt::Integer p) {
+        Cache &cache = GetCache();
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            const auto it = cache.default_roots.find(p);
+            if (it != cache.default_roots.end()) {
+                return it->second;
+            }
+        }
+
+        const nt::Integer g = nt::PrimitiveRootModPrime(p);
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.default_roots.emplace(p, g).first->second;
+    }
+
+    static std::shared_ptr<const NttPlan> Lookup(const nt::Integer p, const size_t size, const nt::Integer g) {
+        Cache &cache = GetCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        const auto it = cache.plans.find(Key(p, size, g));
+        return (it != cache.plans.end()) ? it->second : nullptr;
+    }
+
+    // Plans are built outside of the lock. When two threads race, the first
+    // plan stored wins and both get it.
+    static std::shared_ptr<const NttPlan> Store(std::shared_ptr<const NttPlan> plan) {
+        Cache &cache = GetCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        const Key key(plan->Prime(), plan->Size(), plan->Root());
+        return cache.plans.emplace(key, std::move(plan)).first->second;
+    }
+
+    modular_fft_detail::MontgomeryModulus m_modulus;
+    nt::Integer m_prime;
+    nt::Integer m_root;
+    size_t m_size;
+    int m_log_size;
+
+    std::vector<uint64_t> m_twiddles;
+    std::vector<uint64_t> m_inverse_twiddles;
+    uint64_t m_inverse_size;
+};
+
 template < class InputIt, class OutputIt >
 static void ImplModularFft(InputIt first, InputIt last, OutputIt d_first,
-                            nt::Integer p, nt::Integer g, bool is_inverse_transform) {
+                            const NttPlan &plan, bool is_inverse_transform) {
     
-    const int N = std::distance(first, last);
-    const int logN = fft_utils::IntLog2(N);
-    const int k = (p - 1) / N;
+    const size_t N = std::distance(first, last);
+    const nt::Integer p = plan.Prime();
+    const modular_fft_detail::MontgomeryModulus &mod = plan.Modulus();
 
     // For debugging
-    assert(N == (1 << logN));
-    assert(p % N == 1);
-    assert(nt::IsPrime(p));
-
-    if (is_inverse_transform) {
-        // Multiplicative Inverse of g mod p
-        g = nt::ModularExponentiation(g, p-2, p);
-    }
+    assert(N == plan.Size());
 
     // Stores the bit reversal permutation of [first...last] in d_first
     fft_utils::BitReversalPermutation(first, last, d_first);
 
-    // Take mod p for all elements in d_first
-    for (int i = 1; i < N; i++) {
-        d_first[i] = (d_first[i]) % p;
+    // Bring all elements of d_first to the range [0...p-1]
+    for (size_t i = 0; i < N; i++) {
+        if (d_first[i] < 0 || d_first[i] >= p) {
+            d_first[i] = nt::SafeMod(d_first[i], p);
+        }
     }
 
-    // omega^N === 1 (mod p) since k*N == p-1
-    nt::Integer omega = nt::ModularExponentiation(g, k, p);
-
-    for (int s = 1; s <= logN; s++) {
-        // twiddle is a 2^s root of unity mod p.
-        nt::Integer twiddle = nt::ModularExponentiation(omega, fft_utils::PowerOfTwo(logN - s), p);
-
-        for (int k = 0; k < N; k += fft_utils::PowerOfTwo(s)) {
-            nt::Integer twiddle_factor = 1;
+    for (int s = 1; s <= plan.LogSize(); s++) {
+        // The twiddles are in Montgomery form, which keeps the products in
+        // normal form.
+        const uint64_t *twiddles = plan.StageTwiddles(s, is_inverse_transform);
+        const size_t half = size_t{1} << (s - 1);
 
+        for (size_t k = 0; k < N; k += 2 * half) {
             // Set both halves of the out array at the same time
-            // j = 1, 4, 8, 16, ..., N / 2
-            for (int j = 0; j < fft_utils::PowerOfTwo(s-1); j++) {
-                nt::Integer a = d_first[k + j];
-                nt::Integer b = (twiddle_factor * d_first[k + j + fft_utils::PowerOfTwo(s-1)]) % p;
+            for (size_t j = 0; j < half; j++) {
+                const uint64_t a = d_first[k + j];
+                const uint64_t b = mod.mul(twiddles[j], d_first[k + j + half]);
 
-                // Compute pow(twiddle, j)
-                twiddle_factor = (twiddle_factor * twiddle) % p;
-
-                d_first[k + j] = (a + b) % p;
-                d_first[k + j + fft_utils::PowerOfTwo(s-1)] = (a - b) % p;
+                d_first[k + j] = mod.add(a, b);
+                d_first[k + j + half] = mod.sub(a, b);
             }
         }
     }
+}
+
+template < class InputIt, class OutputIt >
+void ModularFftTransform(InputIt first, InputIt last, OutputIt d_first, const NttPlan &plan) {
+    ImplModularFft(first, last, d_first, plan, false);
+}
+
+template < class InputIt, class OutputIt >
+void ModularFftInverseTransform(InputIt first, InputIt last, OutputIt d_first, const NttPlan &plan) {
 
-    // C++ may use negative remainders. This brings all results to the range
-    // [0...p-1]
-    for (int i = 1; i < N; i++) {
-        d_first[i] = (d_first[i] >= 0) ? d_first[i] : (d_first[i] + p);
+    ImplModularFft(first, last, d_first, plan, true);
+
+    // Divide Output by N (modulo p)
+    const size_t N = std::distance(first, last);
+    const modular_fft_detail::MontgomeryModulus &mod = plan.Modulus();
+    for (size_t i = 0; i < N; i++) {
+        d_first[i] = mod.mul(plan.InverseSize(), d_first[i]);
     }
 }
 
+/// g must be a primitive root modulo p. The plan of (p, N, g) comes from
+/// NttPlan::Cached.
 template < class InputIt, class OutputIt >
 void ModularFftTransform(InputIt first, InputIt last, OutputIt d_first, nt::Integer p,
                          nt::Integer g) {
-    ImplModularFft(first, last, d_first, p, g, false);
+    const auto plan = NttPlan::Cached(p, std::distance(first, last), g);
+    ModularFftTransform(first, last, d_first, *plan);
 }
 
 template < class InputIt, class OutputIt >
 void ModularFftInverseTransform(InputIt first, InputIt last, OutputIt d_first, nt::Integer p,
                          nt::Integer g) {
+    const auto plan = NttPlan::Cached(p, std::distance(first, last), g);
+    ModularFftInverseTransform(first, last, d_first, *plan);
+}
 
-    ImplModularFft(first, last, d_first, p, g, true);
-
-    // Divide Output by N (modulo p)
-    const int N = std::distance(first, last);
-    // Multiplicative inverse of N modulo p
-    const int inv_N = nt::ModularExponentiation(N, p-2, p);
+/// ModularFftTransform as a task of pool. Returns at once; [first, last) and
+/// the output must stay valid until the future is ready.
+template < class InputIt, class OutputIt >
+fft_async::Future<void> AsyncModularFftTransform(InputIt first, InputIt last, OutputIt d_first, nt::Integer p,
+                         nt::Integer g, const ThreadPoolParallelizer &pool = ThreadPoolParallelizer::Shared()) {
+    return fft_async::Async(pool, [first, last, d_first, p, g](){
+        ModularFftTransform(first, last, d_first, p, g);
+    });
+}
 
-    for (int i=0; i<N; i++) {
-        d_first[i] = (d_first[i] * inv_N) % p;
-    }
-}
\ No newline at end of file
+template < class InputIt, class OutputIt >
+fft_async::Future<void> AsyncModularFftInverseTransform(InputIt first, InputIt last, OutputIt d_first, nt::Integer p,
+                         nt::Integer g, const ThreadPoolParallelizer &pool = ThreadPoolParallelizer::Shared()) {
+    return fft_async::Async(pool, [first, last, d_first, p, g](){
+        ModularFftInverseTransform(first, last, d_first, p, g);
+    });
+}
@@ -3,113 +3,849 @@
 #include <iostream>
 #include <vector>
 #include <thread>
+#include <chrono>
+#include <limits>
+#include <cassert>
+
+#include <omp.h>
+
+ThreadBarrier::ThreadBarrier(const size_t num_threads)
+    : m_num_threads(num_threads) {}
+
+void ThreadBarrier::arrive_and_wait() {
+    const size_t generation = m_generation.load(std::memory_order_acquire);
+
+    // The last thread to arrive opens the barrier for the others
+    if (m_count.fetch_add(1, std::memory_order_acq_rel) + 1 == m_num_threads) {
+        m_count.store(0, std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    constexpr int max_spins = 1 << 10;
+    for (int spins = 0; m_generation.load(std::memory_order_acquire) == generation; spins++) {
+        if (spins >= max_spins) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void RegionContext::barrier() const {
+    if (thread_barrier != nullptr) {
+        thread_barrier->arrive_and_wait();
+    }
+    else {
+        #pragma omp barrier
+    }
+}
+
+std::pair<size_t, size_t> RegionContext::share(const size_t length) const {
+    const size_t chunk_size = length / num_threads;
+    const size_t remainder = length % num_threads;
+
+    const size_t first = thread_id * chunk_size + std::min(thread_id, remainder);
+    const size_t last = first + chunk_size + ((thread_id < remainder) ? 1 : 0);
+    return {first, last};
+}
+
+namespace {
+    // Allowance of the calling thread for the nested claims on a budget.
+    // A thread that is not part of a team of the budget may claim all of it.
+    struct ThreadAllowance {
+        const ThreadBudget *budget = nullptr;
+        size_t allowance = std::numeric_limits<size_t>::max();
+    };
+
+    thread_local ThreadAllowance thread_allowance;
+
+    size_t AllowanceOn(const ThreadBudget &budget) {
+        return (thread_allowance.budget == &budget) ? thread_allowance.allowance : std::numeric_limits<size_t>::max();
+    }
+}
+
+ThreadBudget::ThreadBudget(const size_t limit)
+    : m_limit(std::max<size_t>(limit, 1)) {}
+
+ThreadBudget& ThreadBudget::Global() {
+    static ThreadBudget budget(std::max(1u, std::thread::hardware_concurrency()));
+    return budget;
+}
+
+size_t ThreadBudget::limit() const {
+    return m_limit;
+}
+
+size_t ThreadBudget::current() const {
+    return m_current.load(std::memory_order_relaxed);
+}
+
+size_t ThreadBudget::peak() const {
+    return m_peak.load(std::memory_order_relaxed);
+}
+
+ThreadBudget::Claim::Claim(ThreadBudget &budget, const size_t max_team_size)
+    : m_budget(budget) {
+
+    const size_t allowance = AllowanceOn(budget);
+    const size_t wanted = std::min(std::max<size_t>(max_team_size, 1) - 1, allowance);
+
+    // Takes exactly what it claims, whatever the other threads do meanwhile
+    size_t current = budget.m_current.load(std::memory_order_relaxed);
+    size_t new_current;
+    do {
+        const size_t available = (budget.m_limit > current) ? budget.m_limit - current : 0;
+        m_num_claimed = std::min(wanted, available);
+        new_current = current + m_num_claimed;
+    } while (!budget.m_current.compare_exchange_weak(current, new_current, std::memory_order_relaxed));
+
+    size_t peak = budget.m_peak.load(std::memory_order_relaxed);
+    while (peak < new_current && !budget.m_peak.compare_exchange_weak(peak, new_current, std::memory_order_relaxed)) {}
+
+    if (allowance == std::numeric_limits<size_t>::max()) {
+        m_team_allowance = (budget.m_limit > new_current) ? budget.m_limit - new_current : 0;
+    } else {
+        m_team_allowance = allowance - m_num_claimed;
+    }
+}
+
+ThreadBudget::Claim::~Claim() {
+    m_budget.m_current.fetch_sub(m_num_claimed, std::memory_order_relaxed);
+}
+
+size_t ThreadBudget::Claim::team_size() const {
+    return 1 + m_num_claimed;
+}
+
+ThreadBudget::Claim::Member::Member(const Claim &claim, const size_t thread_id)
+    : m_saved_budget(thread_allowance.budget), m_saved_allowance(thread_allowance.allowance) {
+
+    const auto [first, last] = RegionContext{thread_id, claim.team_size()}.share(claim.m_team_allowance);
+    thread_allowance = ThreadAllowance{&claim.m_budget, last - first};
+}
+
+ThreadBudget::Claim::Member::~Member() {
+    thread_allowance = ThreadAllowance{m_saved_budget, m_saved_allowance};
+}
 
 FixedThreadsParallelizer::FixedThreadsParallelizer() 
-    : m_limit_thread_count(std::thread::hardware_concurrency()) {}
+    : m_budget(&ThreadBudget::Global()) {}
 
 FixedThreadsParallelizer::FixedThreadsParallelizer(const size_t limit_thread_count)
-    : m_limit_thread_count(limit_thread_count) {}
+    : m_own_budget(std::make_unique<ThreadBudget>(limit_thread_count)), m_budget(m_own_budget.get()) {}
 
+FixedThreadsParallelizer::FixedThreadsParallelizer(const size_t limit_thread_count, const ThreadPlacement placement)
+    : FixedThreadsParallelizer(limit_thread_count) {
+    m_placement = placement;
+}
 
-FixedThreadsParallelizer::ThreadGuard::ThreadGuard(const FixedThreadsParallelizer *instance, const size_t max_number_threads) 
-    : instance(instance) {
-    
-    // Acquire the maximum number of threads for the loop
-    size_t curr_thread_count = instance->m_thread_count.load();;
-    do {
-        this->n_claimed_threads = std::min(max_number_threads, instance->m_limit_thread_count - curr_thread_count);
-    } while (!instance->m_thread_count.compare_exchange_weak(curr_thread_count, instance->m_limit_thread_count));
+const ThreadBudget& FixedThreadsParallelizer::budget() const {
+    return *m_budget;
 }
 
-FixedThreadsParallelizer::ThreadGuard::~ThreadGuard() {
-    // Acquire the maximum number of threads for the loop
-    size_t curr_thread_count = instance->m_thread_count.load(); 
-    size_t new_thread_count = curr_thread_count - this->n_claimed_threads;
-    
-    while (!instance->m_thread_count.compare_exchange_weak(curr_thread_count, new_thread_count)) {
-        new_thread_count = curr_thread_count - this->n_claimed_threads;
+void FixedThreadsParallelizer::run_team(const ThreadBudget::Claim &claim, const std::function<void(size_t)> &run) const {
+    const auto run_member = [&](const size_t thread_id) {
+        const ThreadBudget::Claim::Member member(claim, thread_id);
+        if (m_placement == ThreadPlacement::kPinned) {
+            const ScopedThreadPin pin(CpuTopology::Detect().cpu_of_thread(thread_id, claim.team_size()));
+            run(thread_id);
+        } else {
+            run(thread_id);
+        }
+    };
+
+    std::vector<std::thread> workers(claim.team_size() - 1);
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i] = std::thread(run_member, i + 1);
+    }
+
+    run_member(0);
+
+    for (auto& worker : workers) {
+        worker.join();
     }
 }
 
 void FixedThreadsParallelizer::parallel_for(const int first, const int last, const std::function<void(int)> &func) const {
     const size_t length = std::max(last - first, 0);
 
-    const ThreadGuard thread_guard(this, length); 
+    const ThreadBudget::Claim claim(*m_budget, length);
+    const size_t num_threads = claim.team_size();
 
-    const size_t num_threads = 1 + thread_guard.n_claimed_threads;
+    run_team(claim, [&](const size_t thread_id) {
+        const auto [work_first, work_last] = RegionContext{thread_id, num_threads}.share(length);
+        for (size_t i = work_first; i < work_last; i++) {
+            func(first + (int) i);
+        }
+    });
+}
 
-    const size_t chunk_size = length / num_threads;
-    const size_t remainder = length % num_threads;
+void FixedThreadsParallelizer::parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const {
+    const ThreadBudget::Claim claim(*m_budget, num_ranges);
+    const size_t num_threads = claim.team_size();
 
-    std::vector<std::thread> workers(num_threads - 1);
+    // One run of consecutive ranges per thread
+    run_team(claim, [&](const size_t thread_id) {
+        const auto [r_first, r_last] = RegionContext{thread_id, num_threads}.share(num_ranges);
+        if (r_first < r_last) {
+            func(r_first, r_last);
+        }
+    });
+}
 
-    auto do_work = [&func](const int work_first, const int work_last) {
-        for (int i = work_first; i < work_last; i++) {
-            func(i);
+void FixedThreadsParallelizer::parallel_calls(std::vector< std::function<void(void)> > funcs) const {
+    // The functions are handed out one by one
+    std::atomic<size_t> next(0);
+    const auto work_loop = [&](size_t){
+        for (size_t k = next.fetch_add(1); k < funcs.size(); k = next.fetch_add(1)) {
+            funcs[k]();
         }
     };
 
-    int work_first = first;
-    for (size_t i = 0; i < num_threads - 1; i++) {
-        const int extra_work = (remainder > i) ? 1 : 0;
-        const int work_last = work_first + chunk_size + extra_work;
+    // It does not make sense to use more threads than there are functions
+    const ThreadBudget::Claim claim(*m_budget, funcs.size());
+    run_team(claim, work_loop);
+}
+
+void FixedThreadsParallelizer::parallel_region(const std::function<void(const RegionContext&)> &func) const {
+    const ThreadBudget::Claim claim(*m_budget, m_budget->limit());
 
-        workers[i] = std::thread(do_work, work_first, work_last);
-        work_first = work_last;
+    const size_t num_threads = claim.team_size();
+    ThreadBarrier barrier(num_threads);
+
+    run_team(claim, [&](const size_t thread_id) {
+        func(RegionContext{thread_id, num_threads, &barrier});
+    });
+}
+
+ThreadPoolParallelizer::ThreadPoolParallelizer()
+    : ThreadPoolParallelizer(std::max(1u, std::thread::hardware_concurrency())) {}
+
+ThreadPoolParallelizer::ThreadPoolParallelizer(const size_t num_threads)
+    : m_assignments(num_threads), m_tasks(TASK_QUEUE_CAPACITY) {
+    // The calling thread is the last thread of every call
+    const size_t num_workers = std::max<size_t>(num_threads, 1) - 1;
+
+    m_num_idle = num_workers;
+    m_workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; i++) {
+        m_workers.emplace_back(&ThreadPoolParallelizer::worker_loop, this);
     }
+}
 
-    // Last thread never does extra work
-    do_work(work_first, last);
+ThreadPoolParallelizer::~ThreadPoolParallelizer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake_up.notify_all();
 
-    for (size_t i = 0; i < num_threads - 1; i++) {
-        workers[i].join();
+    for (auto& worker : m_workers) {
+        worker.join();
     }
 }
 
-void FixedThreadsParallelizer::parallel_calls(std::vector< std::function<void(void)> > funcs) const {
-    
-    AtomicFIFO< std::function<void(void)> > fifo(funcs);
-    const auto work_loop = [&](){
-        while (true) {
-            auto maybe_func = fifo.pop();
-            if (maybe_func.has_value()) {
-                auto func = maybe_func.value();
-                func();
+ThreadPoolParallelizer& ThreadPoolParallelizer::Shared() {
+    static ThreadPoolParallelizer pool;
+    return pool;
+}
+
+size_t ThreadPoolParallelizer::num_threads() const {
+    return 1 + m_workers.size();
+}
+
+ThreadPoolParallelizer::Stats ThreadPoolParallelizer::stats() const {
+    const auto assignments = m_assignments.stats();
+    const auto tasks = m_tasks.stats();
+
+    Stats stats;
+    stats.push_retries = assignments.push_retries + tasks.push_retries;
+    stats.pop_retries = assignments.pop_retries + tasks.pop_retries;
+    stats.overflow = tasks.full;
+    return stats;
+}
+
+bool ThreadPoolParallelizer::take_idle_worker() const {
+    size_t num_idle = m_num_idle.load(std::memory_order_relaxed);
+    while (num_idle > 0) {
+        if (m_num_idle.compare_exchange_weak(num_idle, num_idle - 1, std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPoolParallelizer::push_task(std::function<void(void)> task) const {
+    if (!m_tasks.try_push(std::move(task))) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_overflow_tasks.push(std::move(task));
+        m_num_overflow_tasks.fetch_add(1, std::memory_order_release);
+    }
+    m_num_tasks.fetch_add(1);
+}
+
+std::optional<std::function<void(void)>> ThreadPoolParallelizer::pop_task() const {
+    std::optional<std::function<void(void)>> task = m_tasks.try_pop();
+    if (!task && m_num_overflow_tasks.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_overflow_tasks.empty()) {
+            task = std::move(m_overflow_tasks.front());
+            m_overflow_tasks.pop();
+            m_num_overflow_tasks.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (task) {
+        m_num_tasks.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+void ThreadPoolParallelizer::wake_up_workers(const size_t count) const {
+    // Pairs with the check of the queues by a worker that goes to sleep:
+    // either the worker sees the new items or this sees the worker.
+    if (m_num_sleeping.load() == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (count > 1) {
+        m_wake_up.notify_all();
+    } else {
+        m_wake_up.notify_one();
+    }
+}
+
+void ThreadPoolParallelizer::worker_loop() {
+    // Spin for a short while before parking, which keeps the wake up
+    // latency low when calls follow each other closely.
+    constexpr int max_spins = 1 << 12;
+    int spins = 0;
+
+    while (true) {
+        if (m_num_assignments.load(std::memory_order_acquire) > 0) {
+            if (std::optional<Assignment> assignment = m_assignments.try_pop()) {
+                m_num_assignments.fetch_sub(1, std::memory_order_relaxed);
+
+                Job &job = *assignment->job;
+                (*job.func)(RegionContext{assignment->thread_id, job.num_threads, &job.barrier});
+
+                // Idle again before signalling, so that the caller can reuse
+                // this worker as soon as it returns.
+                m_num_idle.fetch_add(1, std::memory_order_release);
+                job.num_done.fetch_add(1, std::memory_order_release);
+                spins = 0;
+                continue;
             }
-            else {
-                break;
+        }
+
+        // A worker only takes a submitted task if it is idle and not claimed
+        // by a team, which keeps the teams whole. Taking itself out of the
+        // idle workers fails when a team claimed it, whose assignment is then
+        // on its way.
+        if (m_num_tasks.load(std::memory_order_acquire) > 0 && take_idle_worker()) {
+            std::optional<std::function<void(void)>> task = pop_task();
+            if (task) {
+                (*task)();
             }
+            m_num_idle.fetch_add(1, std::memory_order_release);
+
+            if (task) {
+                spins = 0;
+                continue;
+            }
+        }
+
+        if (m_stop.load(std::memory_order_acquire) && m_num_assignments.load() == 0 && m_num_tasks.load() == 0) {
+            return;
+        }
+
+        if (++spins < max_spins) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_num_sleeping.fetch_add(1);
+        m_wake_up.wait(lock, [this](){
+            return m_stop.load() || m_num_assignments.load() > 0
+                || (m_num_tasks.load() > 0 && m_num_idle.load() > 0);
+        });
+        m_num_sleeping.fetch_sub(1);
+        spins = 0;
+    }
+}
+
+void ThreadPoolParallelizer::run(const size_t max_num_threads, const std::function<void(const RegionContext&)> &func) const {
+    // A claimed worker is no longer idle but has no assignment yet. The
+    // workers that are not running anything always outnumber the queued
+    // assignments, so that the threads of a team all run at the same time,
+    // as the barrier of a region requires.
+    const size_t max_claimed = std::max<size_t>(max_num_threads, 1) - 1;
+    size_t num_idle = m_num_idle.load(std::memory_order_relaxed);
+    size_t num_claimed = std::min(num_idle, max_claimed);
+    while (num_claimed > 0
+           && !m_num_idle.compare_exchange_weak(num_idle, num_idle - num_claimed, std::memory_order_acq_rel)) {
+        num_claimed = std::min(num_idle, max_claimed);
+    }
+
+    Job job(&func, 1 + num_claimed);
+
+    if (num_claimed > 0) {
+        for (size_t i = 1; i < job.num_threads; i++) {
+            [[maybe_unused]] const bool pushed = m_assignments.try_push(Assignment{&job, i});
+            assert(pushed);
+        }
+        m_num_assignments.fetch_add(num_claimed);
+        wake_up_workers(num_claimed);
+    }
+
+    func(RegionContext{0, job.num_threads, &job.barrier});
+
+    constexpr int max_spins = 1 << 10;
+    for (int spins = 0; job.num_done.load(std::memory_order_acquire) < num_claimed; spins++) {
+        if (spins >= max_spins) {
+            std::this_thread::yield();
         }
+    }
+}
+
+void ThreadPoolParallelizer::parallel_for(const int first, const int last, const std::function<void(int)> &func) const {
+    const size_t length = std::max(last - first, 0);
+
+    run(length, [&](const RegionContext& region) {
+        const auto [work_first, work_last] = region.share(length);
+        for (size_t i = work_first; i < work_last; i++) {
+            func(first + (int) i);
+        }
+    });
+}
+
+void ThreadPoolParallelizer::parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const {
+    run(num_ranges, [&](const RegionContext& region) {
+        const auto [r_first, r_last] = region.share(num_ranges);
+        if (r_first < r_last) {
+            func(r_first, r_last);
+        }
+    });
+}
+
+void ThreadPoolParallelizer::parallel_calls(std::vector< std::function<void(void)> > funcs) const {
+    // The functions are handed out one by one, as in FixedThreadsParallelizer
+    std::atomic<size_t> next(0);
+
+    run(funcs.size(), [&](const RegionContext&) {
+        for (size_t k = next.fetch_add(1); k < funcs.size(); k = next.fetch_add(1)) {
+            funcs[k]();
+        }
+    });
+}
+
+void ThreadPoolParallelizer::parallel_region(const std::function<void(const RegionContext&)> &func) const {
+    run(num_threads(), func);
+}
+
+void ThreadPoolParallelizer::submit(std::function<void(void)> task) const {
+    if (m_workers.empty()) {
+        task();
+        return;
+    }
+
+    push_task(std::move(task));
+    wake_up_workers(1);
+}
+
+bool ThreadPoolParallelizer::run_pending_task() const {
+    std::optional<std::function<void(void)>> task = pop_task();
+    if (!task) {
+        return false;
+    }
+
+    (*task)();
+    return true;
+}
+
+namespace {
+    // The pool and the index of the worker that runs on this thread
+    struct CurrentWorker {
+        const WorkStealingParallelizer *pool = nullptr;
+        size_t index = 0;
     };
 
-    // It does not make sense to use more threads than there are functions
-    const size_t max_num_threads = funcs.size();
-    const ThreadGuard thread_guard(this, max_num_threads);
+    thread_local CurrentWorker current_worker;
+}
 
-    const size_t num_threads = 1 + thread_guard.n_claimed_threads;
+WorkStealingParallelizer::WorkStealingParallelizer()
+    : WorkStealingParallelizer(std::max(1u, std::thread::hardware_concurrency())) {}
 
-    std::vector<std::thread> workers(num_threads - 1);
-    for (auto& worker : workers) {
-        worker = std::thread(work_loop);
+WorkStealingParallelizer::WorkStealingParallelizer(const size_t num_threads) {
+    // The calling thread helps while it waits for its tasks
+    const size_t num_workers = std::max<size_t>(num_threads, 1) - 1;
+
+    m_num_free = num_workers;
+    for (size_t i = 0; i < num_workers; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < num_workers; i++) {
+        m_workers[i]->thread = std::thread(&WorkStealingParallelizer::worker_loop, this, i);
     }
+}
 
-    work_loop();
+WorkStealingParallelizer::~WorkStealingParallelizer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake_up.notify_all();
 
-    for (auto& worker : workers) {
-        worker.join();
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+WorkStealingParallelizer& WorkStealingParallelizer::Shared() {
+    static WorkStealingParallelizer pool;
+    return pool;
+}
+
+size_t WorkStealingParallelizer::num_threads() const {
+    return 1 + m_workers.size();
+}
+
+void WorkStealingParallelizer::wake_up_workers() const {
+    if (m_num_sleeping.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wake_up.notify_all();
+    }
+}
+
+WorkStealingParallelizer::Task *WorkStealingParallelizer::find_task(const size_t thief) const {
+    if (m_num_injected.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_injected.empty()) {
+            Task *task = m_injected.front();
+            m_injected.pop_front();
+            m_num_injected.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    // Visit the other workers in turn, starting after the thief
+    const size_t num_workers = m_workers.size();
+    for (size_t k = 1; k <= num_workers; k++) {
+        Task *task = m_workers[(thief + k) % num_workers]->deque.steal();
+        if (task != nullptr) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingParallelizer::worker_loop(const size_t index) {
+    current_worker = CurrentWorker{this, index};
+
+    constexpr int max_idle_rounds = 1 << 10;
+    int idle_rounds = 0;
+
+    while (!m_stop.load(std::memory_order_acquire)) {
+        // A claimed worker joins its region first
+        if (m_num_region_assignments.load(std::memory_order_acquire) > 0) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_region_assignments.empty()) {
+                const RegionAssignment assignment = m_region_assignments.front();
+                m_region_assignments.pop();
+                m_num_region_assignments.fetch_sub(1, std::memory_order_relaxed);
+                lock.unlock();
+
+                RegionJob &job = *assignment.job;
+                (*job.func)(RegionContext{assignment.thread_id, job.num_threads, &job.barrier});
+
+                m_num_free.fetch_add(1, std::memory_order_relaxed);
+                job.num_done.fetch_add(1, std::memory_order_release);
+                idle_rounds = 0;
+                continue;
+            }
+        }
+
+        // Taking itself out of the free workers fails when a region claimed
+        // it, whose assignment is then on its way.
+        size_t num_free = m_num_free.load(std::memory_order_relaxed);
+        bool reserved = false;
+        while (num_free > 0 && !reserved) {
+            reserved = m_num_free.compare_exchange_weak(num_free, num_free - 1, std::memory_order_acq_rel);
+        }
+        if (!reserved) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        Task *task = m_workers[index]->deque.pop();
+        if (task == nullptr) {
+            task = find_task(index);
+        }
+        if (task != nullptr) {
+            (*task->func)();
+            task->num_pending->fetch_sub(1, std::memory_order_release);
+        }
+        m_num_free.fetch_add(1, std::memory_order_release);
+
+        if (task != nullptr) {
+            idle_rounds = 0;
+        }
+        else if (++idle_rounds >= max_idle_rounds) {
+            // Park. Forks wake up the sleeping workers, the timeout covers a
+            // fork that raced with the check of m_num_sleeping.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_num_sleeping.fetch_add(1, std::memory_order_relaxed);
+            m_wake_up.wait_for(lock, std::chrono::milliseconds(1), [this](){
+                return m_stop.load(std::memory_order_relaxed) || !m_injected.empty() || !m_region_assignments.empty();
+            });
+            m_num_sleeping.fetch_sub(1, std::memory_order_relaxed);
+            idle_rounds = 0;
+        }
+    }
+}
+
+void WorkStealingParallelizer::fork_join(const std::function<void(void)> *funcs, const size_t count) const {
+    if (count == 0) {
+        return;
+    }
+
+    std::atomic<size_t> num_pending(count - 1);
+    std::vector<Task> tasks(count);
+    for (size_t k = 1; k < count; k++) {
+        tasks[k] = Task{&funcs[k], &num_pending};
+    }
+
+    const bool is_worker = (current_worker.pool == this);
+
+    if (count > 1) {
+        if (is_worker) {
+            // Pushed last to first, so that the owner pops funcs[1] first
+            // and the thieves steal the last functions
+            WorkStealingDeque<Task> &deque = m_workers[current_worker.index]->deque;
+            for (size_t k = count - 1; k >= 1; k--) {
+                if (!deque.push(&tasks[k])) {
+                    funcs[k]();
+                    num_pending.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        else {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t k = 1; k < count; k++) {
+                m_injected.push_back(&tasks[k]);
+            }
+            m_num_injected.fetch_add(count - 1, std::memory_order_release);
+        }
+        wake_up_workers();
+    }
+
+    funcs[0]();
+
+    // Join: run tasks instead of waiting for them
+    constexpr int max_spins = 1 << 10;
+    int spins = 0;
+    while (num_pending.load(std::memory_order_acquire) > 0) {
+        Task *task = nullptr;
+        if (is_worker) {
+            task = m_workers[current_worker.index]->deque.pop();
+            if (task == nullptr) {
+                task = find_task(current_worker.index);
+            }
+        }
+        else if (m_num_injected.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_injected.empty()) {
+                task = m_injected.front();
+                m_injected.pop_front();
+                m_num_injected.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (task != nullptr) {
+            (*task->func)();
+            task->num_pending->fetch_sub(1, std::memory_order_release);
+            spins = 0;
+        }
+        else if (++spins >= max_spins) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void WorkStealingParallelizer::parallel_for(const int first, const int last, const std::function<void(int)> &func) const {
+    if (last <= first) {
+        return;
     }
+
+    // Granularity cutoff: ranges of at most grain indices run as one task
+    const int grain = std::max<int>(1, (last - first) / (8 * num_threads()));
+
+    std::function<void(int, int)> split = [&](const int range_first, const int range_last) {
+        if (range_last - range_first <= grain) {
+            for (int i = range_first; i < range_last; i++) {
+                func(i);
+            }
+            return;
+        }
+
+        const int middle = range_first + (range_last - range_first) / 2;
+        const std::function<void(void)> halves[2] = {
+            [&](){ split(range_first, middle); },
+            [&](){ split(middle, range_last); },
+        };
+        fork_join(halves, 2);
+    };
+
+    split(first, last);
 }
 
+void WorkStealingParallelizer::parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const {
+    // The grain of the caller sets the size of a range, so the halving goes
+    // down to single ranges
+    std::function<void(size_t, size_t)> split = [&](const size_t r_first, const size_t r_last) {
+        if (r_last - r_first <= 1) {
+            if (r_first < r_last) {
+                func(r_first, r_last);
+            }
+            return;
+        }
+
+        const size_t middle = r_first + (r_last - r_first) / 2;
+        const std::function<void(void)> halves[2] = {
+            [&](){ split(r_first, middle); },
+            [&](){ split(middle, r_last); },
+        };
+        fork_join(halves, 2);
+    };
+
+    split(0, num_ranges);
+}
+
+void WorkStealingParallelizer::parallel_calls(std::vector< std::function<void(void)> > funcs) const {
+    fork_join(funcs.data(), funcs.size());
+}
+
+void WorkStealingParallelizer::parallel_region(const std::function<void(const RegionContext&)> &func) const {
+    // Claims the free workers, which will not take a task before they have
+    // joined the region
+    size_t num_free = m_num_free.load(std::memory_order_relaxed);
+    size_t num_claimed = 0;
+    do {
+        num_claimed = std::min(num_free, m_workers.size());
+    } while (num_claimed > 0 && !m_num_free.compare_exchange_weak(num_free, num_free - num_claimed, std::memory_order_acq_rel));
+
+    RegionJob job(&func, 1 + num_claimed);
+
+    if (num_claimed > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 1; i < job.num_threads; i++) {
+                m_region_assignments.push(RegionAssignment{&job, i});
+            }
+            m_num_region_assignments.fetch_add(num_claimed, std::memory_order_release);
+        }
+        m_wake_up.notify_all();
+    }
+
+    func(RegionContext{0, job.num_threads, &job.barrier});
+
+    constexpr int max_spins = 1 << 10;
+    for (int spins = 0; job.num_done.load(std::memory_order_acquire) < num_claimed; spins++) {
+        if (spins >= max_spins) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+namespace {
+    // Depth in the recursion of OmpParallelizer::parallel_calls of the task
+    // that runs on this thread. Tied tasks resume on their own thread, so
+    // the value is saved and restored around each task.
+    thread_local int omp_task_depth = 0;
+}
+
+OmpParallelizer::OmpParallelizer(const int max_task_depth)
+    : m_max_task_depth(max_task_depth) {}
+
 void OmpParallelizer::parallel_for(const int first, const int last, const std::function<void(int)> &func) const {
+    if (omp_in_parallel()) {
+        #pragma omp taskloop
+        for (int k = first; k < last; k++) {
+            func(k);
+        }
+        return;
+    }
+
     #pragma omp parallel for
     for (int k = first; k < last; k++) {
         func(k);
     }
 }
 
-void OmpParallelizer::parallel_calls(std::vector< std::function<void(void)> > funcs) const {
-    #pragma omp parallel for
-    for (size_t k = 0; k < funcs.size(); k++) {
+void OmpParallelizer::parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const {
+    if (omp_in_parallel()) {
+        // One task per thread of the enclosing region
+        const size_t num_tasks = std::min(num_ranges, (size_t) omp_get_num_threads());
+
+        #pragma omp taskloop grainsize(1)
+        for (size_t t = 0; t < num_tasks; t++) {
+            const auto [r_first, r_last] = RegionContext{t, num_tasks}.share(num_ranges);
+            func(r_first, r_last);
+        }
+        return;
+    }
+
+    #pragma omp parallel if (num_ranges > 1)
+    {
+        const RegionContext region{(size_t) omp_get_thread_num(), (size_t) omp_get_num_threads()};
+        const auto [r_first, r_last] = region.share(num_ranges);
+        if (r_first < r_last) {
+            func(r_first, r_last);
+        }
+    }
+}
+
+void OmpParallelizer::task_calls(const std::vector< std::function<void(void)> > &funcs, const int depth) const {
+    const auto run = [&funcs, depth](const size_t k) {
+        const int saved_depth = omp_task_depth;
+        omp_task_depth = depth + 1;
         funcs[k]();
+        omp_task_depth = saved_depth;
+    };
+
+    // The calling thread runs the first function itself
+    for (size_t k = 1; k < funcs.size(); k++) {
+        #pragma omp task default(shared) firstprivate(k)
+        run(k);
+    }
+    run(0);
+
+    #pragma omp taskwait
+}
+
+void OmpParallelizer::parallel_calls(std::vector< std::function<void(void)> > funcs) const {
+    const int depth = omp_task_depth;
+
+    if (funcs.size() <= 1 || depth >= m_max_task_depth) {
+        for (const auto &func : funcs) {
+            func();
+        }
+        return;
+    }
+
+    if (omp_in_parallel()) {
+        task_calls(funcs, depth);
+        return;
+    }
+
+    #pragma omp parallel
+    #pragma omp single
+    task_calls(funcs, depth);
+}
+
+void OmpParallelizer::parallel_region(const std::function<void(const RegionContext&)> &func) const {
+    #pragma omp parallel
+    {
+        func(RegionContext{(size_t) omp_get_thread_num(), (size_t) omp_get_num_threads()});
     }
 }
\ No newline at end of file
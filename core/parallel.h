@@ -4,13 +4,21 @@
 #define CORE_PARALLEL_H
 
 #include <core/dft.h>
+#include <core/affinity.h>
 
 #include <functional>
 #include <thread>
 #include <atomic>
 #include <mutex>
 #include <queue>
+#include <deque>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+#include <cstdint>
 #include <optional>
+#include <algorithm>
+#include <utility>
 
 /// parallel_for
 /// Implements a parallel for loop. 
@@ -19,70 +27,614 @@
 // void parallel_for(const int first, const int last, const std::function<void(int)> &func, const size_t num_threads);
 // void parallel_for(const int first, const int last, const std::function<void(int)> &func);
 
-// Very Simple Thread Safe Queue with mutex locks.
-template <typename T>
-class AtomicFIFO {
+/// parallel_for(first, last, grain, func)
+/// Calls func(range_first, range_last) on the consecutive ranges of grain
+/// indices, the last one possibly shorter, that cover [first, last), in
+/// parallel. func can be any callable and is called directly, so that it
+/// inlines into the loop over the ranges; the bounds are 64-bit.
+// template < class Func >
+// void parallel_for(const size_t first, const size_t last, const size_t grain, const Func &func);
+
+/// parallel_region
+/// Runs func once on each thread of a team, SPMD style.
+///
+/// The threads live for the whole call, so an algorithm made of several
+/// dependent phases forks and joins once and separates its phases with
+/// RegionContext::barrier instead.
+// void parallel_region(const std::function<void(const RegionContext&)> &func);
+
+// Reusable barrier for a fixed number of threads. The threads spin for a
+// short while and then yield, so that an oversubscribed machine still makes
+// progress.
+class ThreadBarrier {
 public:
-    AtomicFIFO(const std::vector<T> &list) {
-        for (auto value : list) {
-            m_fifo.push(std::move(value));
+    explicit ThreadBarrier(const size_t num_threads);
+
+    void arrive_and_wait();
+
+private:
+    const size_t m_num_threads;
+    std::atomic<size_t> m_count{0};
+    std::atomic<size_t> m_generation{0};
+};
+
+/// What a thread of a parallel region knows about the team.
+struct RegionContext {
+    size_t thread_id;
+    size_t num_threads;
+
+    /// Blocks until every thread of the region has reached the barrier.
+    void barrier() const;
+
+    /// The part [first, last) of [0, length) of this thread when length is
+    /// split evenly between the threads.
+    std::pair<size_t, size_t> share(const size_t length) const;
+
+    // nullptr for an OpenMP team, which uses its own barrier.
+    ThreadBarrier *thread_barrier = nullptr;
+};
+
+/// Bounded lock free multi-producer multi-consumer queue (Vyukov). Every
+/// cell carries a sequence number that tells producers and consumers whose
+/// turn it is, so that a push or a pop is a single compare and swap on its
+/// end of the queue when there is no contention. Items are moved in and out.
+///
+/// The retries of the compare and swap are counted, as a measure of the
+/// contention between threads, together with the pushes to a full queue and
+/// the pops from an empty one.
+template < class T >
+class MpmcQueue {
+public:
+    struct Stats {
+        size_t push_retries = 0;
+        size_t pop_retries = 0;
+        size_t full = 0;
+        size_t empty = 0;
+    };
+
+    /// The capacity is rounded up to a power of 2.
+    explicit MpmcQueue(const size_t capacity)
+        : m_cells(RoundUpCapacity(capacity)), m_mask(m_cells.size() - 1) {
+        for (size_t i = 0; i < m_cells.size(); i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Holds the items of list, in order.
+    explicit MpmcQueue(std::vector<T> list) : MpmcQueue(list.size()) {
+        for (auto &value : list) {
+            try_push(std::move(value));
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    size_t capacity() const {
+        return m_cells.size();
+    }
+
+    /// Returns false, and leaves value alone, when the queue is full.
+    bool try_push(T &&value) {
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+                m_push_retries.fetch_add(1, std::memory_order_relaxed);
+            } else if (diff < 0) {
+                m_full.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                m_push_retries.fetch_add(1, std::memory_order_relaxed);
+            }
         }
+
+        cell->value.emplace(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
     }
 
-    void push(const T& value) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_fifo.push(value);
+    bool try_push(const T &value) {
+        return try_push(T(value));
     }
 
-    std::optional<T> pop() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (!m_fifo.empty()) {
-            T output = m_fifo.front();
-            m_fifo.pop();
-            return output;
+    std::optional<T> try_pop() {
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+                m_pop_retries.fetch_add(1, std::memory_order_relaxed);
+            } else if (diff < 0) {
+                m_empty.fetch_add(1, std::memory_order_relaxed);
+                return {};
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                m_pop_retries.fetch_add(1, std::memory_order_relaxed);
+            }
         }
-        return {};
+
+        std::optional<T> output(std::move(*cell->value));
+        cell->value.reset();
+        // The cell is free again for the push one lap later
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return output;
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.push_retries = m_push_retries.load(std::memory_order_relaxed);
+        stats.pop_retries = m_pop_retries.load(std::memory_order_relaxed);
+        stats.full = m_full.load(std::memory_order_relaxed);
+        stats.empty = m_empty.load(std::memory_order_relaxed);
+        return stats;
     }
 
 private:
-    std::queue<T> m_fifo;
-    mutable std::mutex m_mutex;
+    static size_t RoundUpCapacity(const size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence;
+        std::optional<T> value;
+    };
+
+    std::vector<Cell> m_cells;
+    const size_t m_mask;
+
+    // The two ends and the counters on separate cache lines
+    alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+    alignas(64) std::atomic<size_t> m_dequeue_pos{0};
+
+    alignas(64) std::atomic<size_t> m_push_retries{0};
+    std::atomic<size_t> m_pop_retries{0};
+    std::atomic<size_t> m_full{0};
+    std::atomic<size_t> m_empty{0};
+};
+
+// Bounded lock free work stealing deque (Chase and Lev), in the version for
+// C++11 atomics of Le et al. The owner pushes and pops at the bottom, any
+// other thread steals at the top, so the owner only contends with a thief
+// for the last item.
+template < class T >
+class WorkStealingDeque {
+public:
+    static constexpr int64_t CAPACITY = int64_t{1} << 12;
+
+    // Owner only. Returns false when the deque is full.
+    bool push(T *item) {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= CAPACITY) {
+            return false;
+        }
+        m_buffer[bottom & (CAPACITY - 1)].store(item, std::memory_order_relaxed);
+        // Publishes the item, and what it points to, to the thieves
+        m_bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only. Returns nullptr when the deque is empty.
+    T *pop() {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *item = m_buffer[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last item: race the thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread. Returns nullptr when the deque is empty or when another
+    // thread took the item first.
+    T *steal() {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        T *item = m_buffer[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> m_top{0};
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    alignas(64) std::atomic<T*> m_buffer[CAPACITY] = {};
+};
+
+/// The templated parallel_for of the parallelizers. Derived implements
+/// parallel_ranges(num_ranges, func), which calls func(r_first, r_last) on
+/// runs of ranges that cover [0, num_ranges), so that a thread pays for one
+/// indirect call per run instead of one per index.
+template < class Derived >
+class ParallelForRanges {
+public:
+    template < class Func >
+    void parallel_for(const size_t first, const size_t last, const size_t grain, const Func &func) const {
+        if (last <= first) {
+            return;
+        }
+
+        const size_t step = std::max<size_t>(grain, 1);
+        const size_t num_ranges = (last - first - 1) / step + 1;
+
+        static_cast<const Derived&>(*this).parallel_ranges(num_ranges, [&](const size_t r_first, const size_t r_last) {
+            for (size_t r = r_first; r < r_last; r++) {
+                const size_t range_first = first + r * step;
+                func(range_first, range_first + std::min(step, last - range_first));
+            }
+        });
+    }
+};
+
+/// Budget of threads shared by the nested and concurrent calls of
+/// FixedThreadsParallelizer. The calling thread counts as one thread in use.
+///
+/// A call claims the extra threads of its team with a Claim, which gives
+/// back exactly what it took when the call returns. What the budget still
+/// has after a claim is split evenly between the threads of the team, as
+/// their allowance for nested calls: nested calls get a fair share of the
+/// remaining threads, instead of the first of them taking all of them.
+class ThreadBudget {
+public:
+    explicit ThreadBudget(const size_t limit);
+
+    ThreadBudget(const ThreadBudget&) = delete;
+    ThreadBudget& operator=(const ThreadBudget&) = delete;
+
+    /// One thread per core, shared by the whole process.
+    static ThreadBudget& Global();
+
+    size_t limit() const;
+
+    /// Threads in use, the calling thread included.
+    size_t current() const;
+
+    /// Largest number of threads in use so far.
+    size_t peak() const;
+
+    /// The extra threads of a team of at most max_team_size threads, the
+    /// calling thread included. Never more than the budget has left, nor
+    /// than the allowance of the calling thread.
+    class Claim {
+    public:
+        Claim(ThreadBudget &budget, const size_t max_team_size);
+        ~Claim();
+
+        Claim(const Claim&) = delete;
+        Claim& operator=(const Claim&) = delete;
+
+        /// The calling thread and the claimed threads.
+        size_t team_size() const;
+
+        /// Sets the allowance of the thread thread_id of the team while it
+        /// runs its part of the call.
+        class Member {
+        public:
+            Member(const Claim &claim, const size_t thread_id);
+            ~Member();
+
+            Member(const Member&) = delete;
+            Member& operator=(const Member&) = delete;
+
+        private:
+            const ThreadBudget *m_saved_budget;
+            size_t m_saved_allowance;
+        };
+
+    private:
+        ThreadBudget &m_budget;
+        size_t m_num_claimed;
+        // Allowance of the whole team for nested calls
+        size_t m_team_allowance;
+    };
+
+private:
+    const size_t m_limit;
+    std::atomic<size_t> m_current{1};
+    std::atomic<size_t> m_peak{1};
 };
 
-class FixedThreadsParallelizer {
+class FixedThreadsParallelizer : public ParallelForRanges<FixedThreadsParallelizer> {
 public:
+    /// Shares ThreadBudget::Global() with the other parallelizers built
+    /// this way.
     FixedThreadsParallelizer();
+
+    /// Has its own budget of limit_thread_count threads.
     FixedThreadsParallelizer(const size_t limit_thread_count);
 
+    /// With ThreadPlacement::kPinned every thread of a team, the calling
+    /// thread included, runs pinned to CpuTopology::cpu_of_thread for the
+    /// duration of the call.
+    FixedThreadsParallelizer(const size_t limit_thread_count, const ThreadPlacement placement);
+
     void parallel_for(const int first, const int last, const std::function<void(int)> &func) const;
+    using ParallelForRanges::parallel_for;
+
+    void parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const;
 
     void parallel_calls(std::vector< std::function<void(void)> > funcs) const;
 
+    void parallel_region(const std::function<void(const RegionContext&)> &func) const;
+
+    const ThreadBudget& budget() const;
+
 private:
-    size_t m_limit_thread_count;
-    mutable std::atomic<size_t> m_thread_count{1};
-
-    // RAII -
-    // [1] Claim threads on constructor 
-    // [2] Return threads to the Parallelizer on the destructor
-    struct ThreadGuard {
-        size_t n_claimed_threads = 0;
-        const FixedThreadsParallelizer *instance;
-
-        ThreadGuard() = delete;
-        ThreadGuard(const ThreadGuard&) = delete;
-        ThreadGuard(ThreadGuard&&) = delete;
-        ThreadGuard& operator=(const ThreadGuard&) = delete;
-
-        ThreadGuard(const FixedThreadsParallelizer *instance, const size_t max_num_threads = std::numeric_limits<size_t>::max());
-        ~ThreadGuard();
-    };    
+    // Runs run(thread_id) on the calling thread, as thread 0, and on a new
+    // thread for each thread claimed.
+    void run_team(const ThreadBudget::Claim &claim, const std::function<void(size_t)> &run) const;
+
+    std::unique_ptr<ThreadBudget> m_own_budget;
+    ThreadBudget *m_budget;
+    ThreadPlacement m_placement = ThreadPlacement::kFloating;
 };
 
-class OmpParallelizer {
+/// Parallelizer backed by a pool of worker threads that are created once and
+/// parked between calls, so that a call costs a wake up instead of the
+/// creation of its threads.
+///
+/// A call claims the idle workers it can use, up to its amount of work, and
+/// runs with them and the calling thread. Nested or concurrent calls get the
+/// workers that are still idle and run on the calling thread alone if there
+/// are none. Shared() is a process-wide pool with one thread per core.
+class ThreadPoolParallelizer : public ParallelForRanges<ThreadPoolParallelizer> {
 public:
+    ThreadPoolParallelizer();
+    ThreadPoolParallelizer(const size_t num_threads);
+    ~ThreadPoolParallelizer();
+
+    ThreadPoolParallelizer(const ThreadPoolParallelizer&) = delete;
+    ThreadPoolParallelizer& operator=(const ThreadPoolParallelizer&) = delete;
+
+    static ThreadPoolParallelizer& Shared();
+
+    /// The workers and the calling thread.
+    size_t num_threads() const;
+
     void parallel_for(const int first, const int last, const std::function<void(int)> &func) const;
+    using ParallelForRanges::parallel_for;
+
+    void parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const;
+
     void parallel_calls(std::vector< std::function<void(void)> > funcs) const;
+
+    void parallel_region(const std::function<void(const RegionContext&)> &func) const;
+
+    /// Queues task for the first idle worker and returns without waiting for
+    /// it. A pool without workers runs task on the calling thread instead.
+    void submit(std::function<void(void)> task) const;
+
+    /// Runs on the calling thread one of the submitted tasks that no worker
+    /// has started yet. Returns false if there is none.
+    bool run_pending_task() const;
+
+    /// Contention on the queues that hand the threads of the teams and the
+    /// submitted tasks to the workers, see MpmcQueue::Stats. overflow counts
+    /// the tasks submitted while the task queue was full, which wait in a
+    /// locked queue instead.
+    struct Stats {
+        size_t push_retries = 0;
+        size_t pop_retries = 0;
+        size_t overflow = 0;
+    };
+
+    Stats stats() const;
+
+    /// Tasks that fit in the lock free task queue.
+    static constexpr size_t TASK_QUEUE_CAPACITY = 1 << 10;
+
+private:
+    // A call of func on a team of threads.
+    struct Job {
+        const std::function<void(const RegionContext&)> *func;
+        size_t num_threads;
+        ThreadBarrier barrier;
+        std::atomic<size_t> num_done{0};
+
+        Job(const std::function<void(const RegionContext&)> *func, const size_t num_threads)
+            : func(func), num_threads(num_threads), barrier(num_threads) {}
+    };
+
+    struct Assignment {
+        Job *job;
+        size_t thread_id;
+    };
+
+    // Runs func on a team made of the calling thread, as thread 0, and of up
+    // to max_num_threads - 1 idle workers. Returns once all of them are done.
+    void run(const size_t max_num_threads, const std::function<void(const RegionContext&)> &func) const;
+
+    void worker_loop();
+
+    // Takes one worker out of the idle workers, unless a team claimed them all.
+    bool take_idle_worker() const;
+
+    void push_task(std::function<void(void)> task) const;
+    std::optional<std::function<void(void)>> pop_task() const;
+
+    void wake_up_workers(const size_t count) const;
+
+    std::vector<std::thread> m_workers;
+
+    // A claimed worker has at most one assignment queued, so that a queue
+    // with a cell per worker never fills. The tasks that do not fit in their
+    // queue go to the overflow queue, behind m_mutex.
+    mutable MpmcQueue<Assignment> m_assignments;
+    mutable MpmcQueue<std::function<void(void)>> m_tasks;
+    mutable std::queue<std::function<void(void)>> m_overflow_tasks;
+    mutable std::atomic<size_t> m_num_overflow_tasks{0};
+
+    // Upper bounds on the queued assignments and tasks, which the workers
+    // check before they go to the queues.
+    mutable std::atomic<size_t> m_num_assignments{0};
+    mutable std::atomic<size_t> m_num_tasks{0};
+
+    // Workers that run nothing and are not claimed by a team
+    mutable std::atomic<size_t> m_num_idle{0};
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_wake_up;
+    mutable std::atomic<size_t> m_num_sleeping{0};
+    std::atomic<bool> m_stop{false};
+};
+
+/// Parallelizer with a work stealing scheduler, for recursive divide and
+/// conquer code.
+///
+/// parallel_calls forks its functions as tasks and joins them. The tasks go
+/// to the deque of the calling worker, where idle workers steal them, and a
+/// thread waiting for a join runs tasks of its own instead of sleeping. A
+/// recursion of parallel_calls therefore balances itself over the workers,
+/// at any depth, without oversubscribing. parallel_for splits its range in
+/// halves down to a grain of about 1/8 of the range per thread.
+/// parallel_region, which needs all of its threads at the same time, runs
+/// on the calling thread and the workers that are idle.
+class WorkStealingParallelizer : public ParallelForRanges<WorkStealingParallelizer> {
+public:
+    WorkStealingParallelizer();
+    WorkStealingParallelizer(const size_t num_threads);
+    ~WorkStealingParallelizer();
+
+    WorkStealingParallelizer(const WorkStealingParallelizer&) = delete;
+    WorkStealingParallelizer& operator=(const WorkStealingParallelizer&) = delete;
+
+    static WorkStealingParallelizer& Shared();
+
+    /// The workers and the calling thread.
+    size_t num_threads() const;
+
+    void parallel_for(const int first, const int last, const std::function<void(int)> &func) const;
+    using ParallelForRanges::parallel_for;
+
+    void parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const;
+
+    void parallel_calls(std::vector< std::function<void(void)> > funcs) const;
+
+    void parallel_region(const std::function<void(const RegionContext&)> &func) const;
+
+private:
+    struct Task {
+        const std::function<void(void)> *func;
+        std::atomic<size_t> *num_pending;
+    };
+
+    struct Worker {
+        WorkStealingDeque<Task> deque;
+        std::thread thread;
+    };
+
+    // A thread of a parallel region, see ThreadPoolParallelizer.
+    struct RegionJob {
+        const std::function<void(const RegionContext&)> *func;
+        size_t num_threads;
+        ThreadBarrier barrier;
+        std::atomic<size_t> num_done{0};
+
+        RegionJob(const std::function<void(const RegionContext&)> *func, const size_t num_threads)
+            : func(func), num_threads(num_threads), barrier(num_threads) {}
+    };
+
+    struct RegionAssignment {
+        RegionJob *job;
+        size_t thread_id;
+    };
+
+    // Runs funcs[1...count) as tasks and funcs[0] on the calling thread,
+    // and returns once all of them are done.
+    void fork_join(const std::function<void(void)> *funcs, const size_t count) const;
+
+    // A task of another worker or of a thread outside the pool, or nullptr.
+    Task *find_task(const size_t thief) const;
+
+    void worker_loop(const size_t index);
+
+    void wake_up_workers() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    // Tasks forked by threads that are not workers of this pool
+    mutable std::mutex m_mutex;
+    mutable std::deque<Task*> m_injected;
+    mutable std::atomic<size_t> m_num_injected{0};
+
+    // Workers that neither run a task nor belong to a region. A worker
+    // takes itself out before it looks for a task, a region takes out the
+    // workers it claims.
+    mutable std::atomic<size_t> m_num_free{0};
+    mutable std::queue<RegionAssignment> m_region_assignments;
+    mutable std::atomic<size_t> m_num_region_assignments{0};
+
+    mutable std::condition_variable m_wake_up;
+    mutable std::atomic<size_t> m_num_sleeping{0};
+    std::atomic<bool> m_stop{false};
+};
+
+/// Parallelizer on OpenMP.
+///
+/// parallel_region is one omp parallel region, in which the iterative engine
+/// runs all of its passes separated by omp barriers. parallel_calls maps a
+/// recursion to omp tasks: the outermost call opens a region, and the calls
+/// made inside it spawn tasks of that region, down to max_task_depth levels
+/// of recursion below which they run sequentially. Nested omp parallel
+/// regions would run on a single thread. For the same reason parallel_for and
+/// parallel_ranges called inside a region run as an omp taskloop.
+class OmpParallelizer : public ParallelForRanges<OmpParallelizer> {
+public:
+    static constexpr int DEFAULT_MAX_TASK_DEPTH = 8;
+
+    explicit OmpParallelizer(const int max_task_depth = DEFAULT_MAX_TASK_DEPTH);
+
+    void parallel_for(const int first, const int last, const std::function<void(int)> &func) const;
+    using ParallelForRanges::parallel_for;
+    void parallel_ranges(const size_t num_ranges, const std::function<void(size_t, size_t)> &func) const;
+    void parallel_calls(std::vector< std::function<void(void)> > funcs) const;
+    void parallel_region(const std::function<void(const RegionContext&)> &func) const;
+
+private:
+    // Runs funcs as tasks of the enclosing region, at the given depth of the
+    // recursion, and waits for them.
+    void task_calls(const std::vector< std::function<void(void)> > &funcs, const int depth) const;
+
+    int m_max_task_depth;
 };
 
 #endif
\ No newline at end of file
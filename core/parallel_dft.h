@@ -12,36 +12,120 @@
 #include <future>
 
 #include <core/parallel.h>
+#include <core/async.h>
 #include <core/fft_types.h>
 #include <core/fft_utils.h>
+#include <core/fft_plan.h>
 
 namespace dft_detail {
     template < class InputIt, class OutputIt, class ImplParallel, class Parallelizer >
     struct WrapperParallel {
 
         void call(InputIt first, InputIt last, OutputIt d_first, bool is_inverse_transform, const Parallelizer& parallelizer) {
+            call_impl(first, last, d_first, is_inverse_transform, parallelizer, is_inverse_transform);
+        }
+
+        // Plan is one of the plan classes (FftPlan, FourStepPlan, ...).
+        template < class Plan >
+        void call(InputIt first, InputIt last, OutputIt d_first, const Plan &plan, const Parallelizer& parallelizer) {
+            assert((size_t) std::distance(first, last) == plan.Size());
+            call_impl(first, last, d_first, plan.IsInverse(), parallelizer, plan);
+        }
+
+    private:
+        // impl_arg is forwarded to ImplParallel after the stride: either the
+        // direction of the transform or a precomputed plan.
+        template < class ImplArg >
+        void call_impl(InputIt first, InputIt last, OutputIt d_first, bool is_inverse_transform,
+                       const Parallelizer& parallelizer, const ImplArg& impl_arg) {
 
             const bool condition = IsMemEqual(first, d_first);
             const size_t N = std::distance(first, last);
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
 
             if (!condition) {
-                ImplParallel{}.template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, 1, is_inverse_transform, parallelizer);
-            }
-            else {
-                std::vector<ComplexType> storage(N);
-                ImplParallel{}.template operator()<InputIt, typename std::vector<ComplexType>::iterator, Parallelizer>(first, last, storage.begin(), 1, is_inverse_transform, parallelizer);
-                std::copy(storage.begin(), storage.end(), d_first);
+                ImplParallel{}.template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, 1, impl_arg, parallelizer);
+                if (is_inverse_transform) {
+                    std::for_each(d_first, d_first + N, [N](ComplexType& value){ value /= (ComplexType) N; });
+                }
+                return;
             }
 
+            // The copy back from the scratch buffer also normalizes. The
+            // threads of the parallelizer initialize the scratch buffer.
+            FirstTouchBuffer<ComplexType> storage(N, parallelizer);
+            ImplParallel{}.template operator()<InputIt, ComplexType*, Parallelizer>(first, last, storage.begin(), 1, impl_arg, parallelizer);
             if (is_inverse_transform) {
-                std::for_each(d_first, d_first + N, [N](ComplexType& value){ value /= (ComplexType) N; });
+                std::transform(storage.begin(), storage.end(), d_first, [N](const ComplexType& value){ return value / (ComplexType) N; });
+            } else {
+                std::copy(storage.begin(), storage.end(), d_first);
             }
         }
     };
 }
 
 
+namespace dft_detail {
+    // Below this size the split radix recursion runs sequentially
+    constexpr int PARALLEL_SPLIT_RADIX_MIN_LOG_SIZE = 12;
+
+    // Parallel version of SplitRadix: the three sub-transforms run through
+    // parallel_calls and the combination is split in chunks over parallel_for.
+    template < class OutputIt, class Float, class Parallelizer >
+    void ParallelSplitRadix(OutputIt data, int logn, const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
+        if (logn < PARALLEL_SPLIT_RADIX_MIN_LOG_SIZE) {
+            SplitRadix(data, logn, plan);
+            return;
+        }
+
+        const size_t n = size_t{1} << logn;
+
+        const std::vector< std::function<void(void)> > tasks = {
+            [&](){ ParallelSplitRadix(data, logn - 1, plan, parallelizer); },
+            [&](){ ParallelSplitRadix(data + n / 2, logn - 2, plan, parallelizer); },
+            [&](){ ParallelSplitRadix(data + 3 * n / 4, logn - 2, plan, parallelizer); },
+        };
+        parallelizer.parallel_calls(tasks);
+
+        constexpr size_t chunk = size_t{1} << (PARALLEL_SPLIT_RADIX_MIN_LOG_SIZE - 2);
+        const auto combine = [&](size_t k_first, size_t k_last) {
+            SplitRadixCombine(data, logn, k_first, k_last, plan);
+        };
+        parallelizer.parallel_for(0, n / 4, chunk, combine);
+    }
+
+    // Below this size the mixed radix recursion runs sequentially
+    constexpr size_t PARALLEL_MIXED_RADIX_MIN_SIZE = size_t{1} << 12;
+
+    // Parallel version of MixedRadix: the sub-transforms run through
+    // parallel_calls and the combination is split in chunks over parallel_for.
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelMixedRadix(InputIt first, OutputIt d_first, size_t stride, size_t n, size_t level,
+                            const MixedRadixPlan<Float> &plan, const Parallelizer& parallelizer) {
+        if (n < PARALLEL_MIXED_RADIX_MIN_SIZE) {
+            MixedRadix(first, d_first, stride, n, level, plan);
+            return;
+        }
+
+        const int r = plan.Radices()[level];
+        const size_t m = n / r;
+
+        std::vector< std::function<void(void)> > tasks;
+        for (int q = 0; q < r; q++) {
+            tasks.push_back([&, q](){
+                ParallelMixedRadix(first + q * stride, d_first + q * m, stride * r, m, level + 1, plan, parallelizer);
+            });
+        }
+        parallelizer.parallel_calls(tasks);
+
+        constexpr size_t chunk = PARALLEL_MIXED_RADIX_MIN_SIZE / 4;
+        const auto combine = [&](size_t k_first, size_t k_last) {
+            MixedRadixCombine(d_first, n, r, k_first, k_last, plan);
+        };
+        parallelizer.parallel_for(0, m, chunk, combine);
+    }
+}
+
 // Implements O(N^2) dft
 namespace base_dft {
 
@@ -50,25 +134,30 @@ namespace base_dft {
         void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
                         bool is_inverse_transform, const Parallelizer& parallelizer) {
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
 
             const size_t N = std::distance(first, last);
             const size_t n = 1 + (N - 1)/stride;
 
-            const auto task = [&](int k) {
-                ComplexType twiddle = (ComplexType) fft_utils::RootOfUnity(n, is_inverse_transform ? k : -((int) k));
+            const auto task = [&](size_t k_first, size_t k_last) {
+                for (size_t k = k_first; k < k_last; k++) {
+                    ComplexType twiddle = fft_utils::PreciseRootOfUnity<Float>(n, is_inverse_transform ? (long long) k : -((long long) k));
 
-                d_first[k] = (ComplexType) 0;
-                ComplexType twiddle_factor = (ComplexType) 1; 
+                    d_first[k] = (ComplexType) 0;
+                    ComplexType twiddle_factor = (ComplexType) 1; 
 
-                for (size_t m = 0; m < N; m += stride) {
-                    d_first[k] += first[m] * twiddle_factor;
-                    
-                    // twiddle_factor = root_of_unity^(k * (m+1)) afte the following line
-                    twiddle_factor *= twiddle;
+                    for (size_t m = 0; m < N; m += stride) {
+                        d_first[k] += first[m] * twiddle_factor;
+                        
+                        // twiddle_factor = root_of_unity^(k * (m+1)) afte the following line
+                        twiddle_factor *= twiddle;
+                    }
                 }
             };
 
-            parallelizer.parallel_for(0, n, task);
+            // Every output costs O(n), a few of them already pay for a task
+            constexpr size_t grain = 4;
+            parallelizer.parallel_for(0, n, grain, task);
         }
     };
 
@@ -90,6 +179,10 @@ namespace recursive_fft {
     // Implementation inspired by pseudocode in
     // https://en.wikipedia.org/wiki/Cooley%E2%80%93Tukey_FFT_algorithm
 
+    // Below this size the recursion runs sequentially: a task of 2^12
+    // points is worth more than forking it.
+    constexpr int PARALLEL_RECURSIVE_MIN_LOG_SIZE = 12;
+
     struct ImplParallelDFT {
 
         template < class InputIt, class OutputIt, typename Parallelizer >
@@ -97,47 +190,73 @@ namespace recursive_fft {
                         bool is_inverse_transform, const Parallelizer& parallelizer) {
             
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            if (n <= RECURSIVE_FFT_BASE_CASE_SIZE) {
+                assert(fft_utils::IsPowerOfTwo(n));
+                fft_codelets::RunCodelet(fft_utils::IntLog2(n), is_inverse_transform, first, stride, d_first);
+                return;
+            }
+
+            const FftPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan, parallelizer);
+        }
+
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
 
             const size_t N = std::distance(first, last);
             const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
 
             if (n <= RECURSIVE_FFT_BASE_CASE_SIZE) {
-                base_dft::ImplDFT{}.template operator()<InputIt, OutputIt>(first, last, d_first, stride, is_inverse_transform);
+                fft_codelets::RunCodelet(plan.LogSize(), plan.IsInverse(), first, stride, d_first);
                 return;
             }
 
-            if (n % 2 != 0) {
-                std::cout << n << std::endl;
+            Recurse(first, d_first, stride, plan.LogSize(), plan, parallelizer);
+        }
+
+    private:
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void Recurse(InputIt first, OutputIt d_first, size_t stride, int logn,
+                     const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+
+            if (logn < PARALLEL_RECURSIVE_MIN_LOG_SIZE) {
+                ImplDFT{}.Recurse(first, d_first, stride, logn, plan);
+                return;
             }
-            assert(n % 2 == 0);
 
+            const size_t n = size_t{1} << logn;
 
             const auto task1 = [&]() {
                 // Even terms 0, 2*stride, 4*stride,...
-                this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, 2*stride, is_inverse_transform, parallelizer);
+                Recurse(first, d_first, 2*stride, logn - 1, plan, parallelizer);
             };
 
             const auto task2 = [&]() {
                 // Odd terms 1*stride, 3*stride, ...
-                this->template operator()<InputIt, OutputIt, Parallelizer>(first + stride, last, d_first + n/2, 2*stride, is_inverse_transform, parallelizer);
+                Recurse(first + stride, d_first + n/2, 2*stride, logn - 1, plan, parallelizer);
             };
 
             const std::vector< std::function<void(void)> > tasks = {task1, task2};
             parallelizer.parallel_calls(tasks);
 
-            // exp(2PI i/n) if IDFT
-            // else exp(-2PI i/n)
-            ComplexType root_of_unity = (ComplexType) fft_utils::RootOfUnity(n, is_inverse_transform ? 1 : -1);
-            ComplexType twiddle = (ComplexType) 1;
+            // twiddles[k] = exp(2PI i k/n) if IDFT
+            // else exp(-2PI i k/n)
+            const auto twiddles = plan.StageTwiddles(logn);
 
             for (size_t k = 0; k < n/2; k++) {
                 ComplexType p = d_first[k];
-                ComplexType q = twiddle * d_first[k + n/2];
+                ComplexType q = (ComplexType) twiddles[k] * d_first[k + n/2];
                 d_first[k] = p + q;
                 d_first[k + n/2] = p - q;
-
-                // twiddle = root_of_unity^(k+1) after next line
-                twiddle *= root_of_unity;
             }
         } 
     };
@@ -153,6 +272,20 @@ namespace recursive_fft {
         dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
         wrapper.call(first, last, d_first, true, parallelizer);
     } 
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    } 
 }; // namespace recursive_fft
 
 namespace iterative_fft {
@@ -166,47 +299,244 @@ namespace iterative_fft {
                         bool is_inverse_transform, const Parallelizer& parallelizer) {
             
             using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
 
             const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const FftPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan, parallelizer);
+        }
 
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
+            this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan, (Float) 1, parallelizer);
+        }
+
+        // Transform multiplied by scale, in place when the output is the input,
+        // see iterative_fft::ImplDFT.
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FftPlan<Float> &plan, Float scale, const Parallelizer& parallelizer) {
+
+            const size_t N = std::distance(first, last);
             const size_t n = 1 + (N - 1)/stride;
-            const size_t logn = fft_utils::IntLog2(n);
+            const int logn = plan.LogSize();
+            assert(n == plan.Size());
 
-            for (size_t i = 0; i < n; i++) {
-                // Reverse the logN bits in the index.
-                size_t rev = fft_utils::ReverseBits(i, logn);
+            const bool in_place = dft_detail::IsMemEqual(first, d_first);
+            assert(!in_place || stride == 1);
 
+            if (plan.Decomposition() == FftDecomposition::kSplitRadix) {
                 // Base case: set the output to the bit-reversed input.
-                d_first[i] = first[stride * rev];
+                if (stride == 1) {
+                    fft_utils::ParallelBitReversalPermutation(first, first + n, d_first, parallelizer);
+                }
+                else {
+                    for (size_t i = 0; i < n; i++) {
+                        d_first[i] = first[stride * plan.BitReversedIndex(i)];
+                    }
+                }
+
+                dft_detail::ParallelSplitRadix(d_first, logn, plan, parallelizer);
+                dft_detail::Scale(d_first, n, scale);
+                return;
             }
 
-            int transform_sign = is_inverse_transform ? -1 : 1;
-            // Loop over 2, 4, 8, 16, ..., n
-            for (size_t s = 1; s <= logn; s++) {
-                // twiddle = exp(-2 PI i / 2^s)
-                ComplexType twiddle = (ComplexType) fft_utils::RootOfUnity(fft_utils::PowerOfTwo(s), -transform_sign);
+            if (logn <= fft_codelets::CODELET_MAX_LOG_SIZE) {
+                if (in_place) {
+                    fft_utils::BitReversalPermutation(d_first, d_first + n, d_first);
+                    fft_codelets::RunBitReversedCodelet(logn, plan.IsInverse(), d_first);
+                } else {
+                    fft_codelets::RunCodelet(logn, plan.IsInverse(), first, stride, d_first);
+                }
+                dft_detail::Scale(d_first, n, scale);
+                return;
+            }
 
+            if (in_place) {
+                fft_utils::ParallelBitReversalPermutation(d_first, d_first + n, d_first, parallelizer);
+            }
 
-                // Iterate through out in strides of length m=2**s
-                // Set k to 0, 2^s, 2 * 2^s, 3 * 2^s, ..., N-2^s
-                const auto task = [&](int k) {
-                    k *= fft_utils::PowerOfTwo(s);
-                    ComplexType twiddle_factor = (ComplexType) 1;
+            // The leaves and all the passes run in a single parallel region,
+            // with a barrier between two passes, instead of a fork and join
+            // per pass.
+            parallelizer.parallel_region([&](const RegionContext& region) {
+                PassesSPMD(first, stride, d_first, in_place, plan, scale, region);
+            });
+        }
 
-                    for (size_t j = 0; j < (size_t) fft_utils::PowerOfTwo(s-1); j++) {
-                        ComplexType a = d_first[k + j];
-                        ComplexType b = twiddle_factor * d_first[k + j + fft_utils::PowerOfTwo(s-1)];
-                        d_first[k + j] = a + b;
-                        d_first[k + j + fft_utils::PowerOfTwo(s-1)] = a - b;
+    private:
+        // Size of the column chunks of the split blocks, so that two threads
+        // never write to the same cache line.
+        static constexpr size_t COLUMN_CHUNK_SIZE = 16;
+
+        // The share of one thread of the leaves and of every pass. A pass with
+        // at least as many blocks as threads gives each thread whole blocks.
+        // The last passes have only a few large blocks: their columns are
+        // then split instead, so that every thread still has work.
+        template < class InputIt, class OutputIt, class Float >
+        static void PassesSPMD(InputIt first, size_t stride, OutputIt d_first, bool in_place,
+                               const FftPlan<Float> &plan, Float scale, const RegionContext& region) {
+            const size_t n = plan.Size();
+            const int logn = plan.LogSize();
+
+            // Codelet leaves, see the sequential engine. In place, they run on
+            // the bit reversed data.
+            constexpr int leaf_log = fft_codelets::CODELET_LEAF_LOG_SIZE;
+            const auto [r_first, r_last] = region.share(n >> leaf_log);
+            if (in_place) {
+                dft_detail::BitReversedLeaves(d_first, leaf_log, r_first, r_last, plan.IsInverse(), scale);
+            } else {
+                dft_detail::CodeletLeaves(first, stride, d_first, logn, leaf_log, r_first, r_last, plan.IsInverse(), scale);
+            }
 
-                        twiddle_factor *= twiddle;
+            // Each pass covers the stages s, ..., s + r - 1, with blocks of
+            // length 2L, 4L, ..., n. A pass that starts among the stages of the
+            // leaves is cut down to its remaining stages.
+            int s = 1;
+            for (int r : plan.Passes()) {
+                const int done = std::min(r, std::max(0, leaf_log + 1 - s));
+                if (done == r) {
+                    s += r;
+                    continue;
+                }
+                region.barrier();
+
+                const size_t block = size_t{1} << (s - 1 + r);
+                const size_t blocks = n / block;
+
+                if (blocks >= region.num_threads) {
+                    const auto [b_first, b_last] = region.share(blocks);
+                    for (size_t b = b_first; b < b_last; b++) {
+                        dft_detail::RadixPass(d_first + b * block, block, s + done, r - done, plan);
                     }
-                };
-                parallelizer.parallel_for(0,  n / fft_utils::PowerOfTwo(s), task);
+                }
+                else {
+                    // The pass reads the columns j < 2^(s + done - 1) of each
+                    // block, at least 2^leaf_log of them.
+                    const size_t columns = size_t{1} << (s + done - 1);
+                    const size_t chunks = columns / COLUMN_CHUNK_SIZE;
+                    const auto [c_first, c_last] = region.share(blocks * chunks);
+                    for (size_t c = c_first; c < c_last; ) {
+                        const size_t b = c / chunks;
+                        const size_t c_block_last = std::min(c_last, (b + 1) * chunks);
+                        dft_detail::RadixPassColumns(d_first + b * block, s + done, r - done,
+                                                     (c - b * chunks) * COLUMN_CHUNK_SIZE,
+                                                     (c_block_last - b * chunks) * COLUMN_CHUNK_SIZE, plan);
+                        c = c_block_last;
+                    }
+                }
+                s += r;
             }
         }
     }; 
 
+    // In place calls and the normalization run inside the engine, see the
+    // sequential iterative_fft::DFT.
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        ImplParallelDFT{}(first, last, d_first, 1, plan, (Float) 1, parallelizer);
+    }
+
+    /// With FftNormalization::kNone the result is not divided by N.
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan, const Parallelizer& parallelizer,
+                      FftNormalization normalization = FftNormalization::kByN) {
+        assert(plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        const Float scale = (normalization == FftNormalization::kByN) ? (Float) 1 / (Float) plan.Size() : (Float) 1;
+        ImplParallelDFT{}(first, last, d_first, 1, plan, scale, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using Float = typename ComplexType::value_type;
+
+        const FftPlan<Float> plan(std::distance(first, last), false);
+        ParallelDFT(first, last, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using Float = typename ComplexType::value_type;
+
+        const FftPlan<Float> plan(std::distance(first, last), true);
+        ParallelIDFT(first, last, d_first, plan, parallelizer);
+    }
+
+    /// ParallelDFT as a task of pool, which also runs the transform. Returns
+    /// at once; [first, last) and the output must stay valid until the
+    /// future is ready.
+    template < class InputIt, class OutputIt >
+    fft_async::Future<void> AsyncParallelDFT(InputIt first, InputIt last, OutputIt d_first,
+                                             const ThreadPoolParallelizer &pool = ThreadPoolParallelizer::Shared()) {
+        return fft_async::Async(pool, [first, last, d_first, &pool](){
+            ParallelDFT(first, last, d_first, pool);
+        });
+    }
+
+    template < class InputIt, class OutputIt >
+    fft_async::Future<void> AsyncParallelIDFT(InputIt first, InputIt last, OutputIt d_first,
+                                              const ThreadPoolParallelizer &pool = ThreadPoolParallelizer::Shared()) {
+        return fft_async::Async(pool, [first, last, d_first, &pool](){
+            ParallelIDFT(first, last, d_first, pool);
+        });
+    }
+}; // namespace iterative_fft
+
+namespace four_step_fft {
+
+    struct ImplParallelDFT {
+
+        template < class InputIt, class OutputIt, typename Parallelizer >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform, const Parallelizer& parallelizer) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const FourStepPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan, parallelizer);
+        }
+
+        // The row transforms are independent and the transposes are split in
+        // bands of source rows, see fft_utils::ParallelBlockedTranspose.
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const FourStepPlan<Float> &plan, const Parallelizer& parallelizer) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
+
+            const size_t rows = plan.Rows();
+            const size_t columns = plan.Columns();
+            std::vector<ComplexType> scratch(n);
+
+            fft_utils::ParallelBlockedTranspose(first, d_first, columns, rows, parallelizer, stride);
+            parallelizer.parallel_for(0, rows, 1, [&](size_t j_first, size_t j_last) {
+                dft_detail::FourStepRows(d_first, scratch.begin(), j_first, j_last, plan, true);
+            });
+            fft_utils::ParallelBlockedTranspose(scratch.begin(), d_first, rows, columns, parallelizer);
+            parallelizer.parallel_for(0, columns, 1, [&](size_t j_first, size_t j_last) {
+                dft_detail::FourStepRows(d_first, scratch.begin(), j_first, j_last, plan, false);
+            });
+            fft_utils::ParallelBlockedTranspose(scratch.begin(), d_first, columns, rows, parallelizer);
+        }
+    };
+
     template < class InputIt, class OutputIt, class Parallelizer >
     void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
         dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
@@ -218,7 +548,456 @@ namespace iterative_fft {
         dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
         wrapper.call(first, last, d_first, true, parallelizer);
     } 
-}; // namespace iterative_fft
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const FourStepPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const FourStepPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    } 
+}; // namespace four_step_fft
+
+namespace mixed_radix_fft {
+
+    struct ImplParallelDFT {
+
+        template < class InputIt, class OutputIt, typename Parallelizer >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform, const Parallelizer& parallelizer) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const MixedRadixPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan, parallelizer);
+        }
+
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const MixedRadixPlan<Float> &plan, const Parallelizer& parallelizer) {
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
+
+            dft_detail::ParallelMixedRadix(first, d_first, stride, n, 0, plan, parallelizer);
+        }
+    };
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, false, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, true, parallelizer);
+    } 
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const MixedRadixPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const MixedRadixPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    } 
+}; // namespace mixed_radix_fft
+
+namespace bluestein_fft {
+
+    struct ImplParallelDFT {
+
+        template < class InputIt, class OutputIt, typename Parallelizer >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        bool is_inverse_transform, const Parallelizer& parallelizer) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using Float = typename ComplexType::value_type;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+
+            const BluesteinPlan<Float> plan(n, is_inverse_transform);
+            this->template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan, parallelizer);
+        }
+
+        template < class InputIt, class OutputIt, typename Parallelizer, class Float >
+        void operator()(InputIt first, InputIt last, OutputIt d_first, size_t stride,
+                        const BluesteinPlan<Float> &plan, const Parallelizer& parallelizer) {
+
+            using ComplexType = typename std::iterator_traits<OutputIt>::value_type; 
+            using PlanComplex = std::complex<Float>;
+
+            const size_t N = std::distance(first, last);
+            const size_t n = 1 + (N - 1)/stride;
+            assert(n == plan.Size());
+
+            if (plan.IsPowerOfTwo()) {
+                iterative_fft::ImplParallelDFT{}.template operator()<InputIt, OutputIt, Parallelizer>(first, last, d_first, stride, plan.DirectPlan(), parallelizer);
+                return;
+            }
+
+            const size_t m = plan.ConvolutionSize();
+            const PlanComplex *chirp = plan.Chirp();
+            const PlanComplex *filter_spectrum = plan.FilterSpectrum();
+
+            std::vector<PlanComplex> signal(m, (PlanComplex) 0);
+            std::vector<PlanComplex> spectrum(m);
+
+            // The pointwise products are split in chunks of PARALLEL_CHUNK_SIZE
+            const auto modulate = [&](size_t k_first, size_t k_last) {
+                for (size_t k = k_first; k < k_last; k++) {
+                    signal[k] = chirp[k] * (PlanComplex) first[stride * k];
+                }
+            };
+            parallelizer.parallel_for(0, n, PARALLEL_CHUNK_SIZE, modulate);
+
+            iterative_fft::ImplParallelDFT{}(signal.begin(), signal.end(), spectrum.begin(), 1, plan.ForwardPlan(), parallelizer);
+
+            const auto filter = [&](size_t k_first, size_t k_last) {
+                for (size_t k = k_first; k < k_last; k++) {
+                    spectrum[k] *= filter_spectrum[k];
+                }
+            };
+            parallelizer.parallel_for(0, m, PARALLEL_CHUNK_SIZE, filter);
+
+            iterative_fft::ImplParallelDFT{}(spectrum.begin(), spectrum.end(), signal.begin(), 1, plan.InversePlan(), parallelizer);
+
+            const auto demodulate = [&](size_t k_first, size_t k_last) {
+                for (size_t k = k_first; k < k_last; k++) {
+                    d_first[k] = (ComplexType) (chirp[k] * signal[k]);
+                }
+            };
+            parallelizer.parallel_for(0, n, PARALLEL_CHUNK_SIZE, demodulate);
+        }
+
+    private:
+        static constexpr size_t PARALLEL_CHUNK_SIZE = size_t{1} << 12;
+    };
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, false, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, true, parallelizer);
+    } 
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const BluesteinPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const BluesteinPlan<Float> &plan, const Parallelizer& parallelizer) {
+        assert(plan.IsInverse());
+        dft_detail::WrapperParallel<InputIt, OutputIt, ImplParallelDFT, Parallelizer> wrapper;
+        wrapper.call(first, last, d_first, plan, parallelizer);
+    } 
+}; // namespace bluestein_fft
+
+namespace dft_detail {
+    // The packing and the twiddle passes of the real transforms are split in
+    // chunks of PARALLEL_REAL_CHUNK_SIZE indices.
+    constexpr size_t PARALLEL_REAL_CHUNK_SIZE = size_t{1} << 12;
+
+    template < class Func, class Parallelizer >
+    void ParallelForRealChunks(size_t count, const Func &func, const Parallelizer& parallelizer) {
+        parallelizer.parallel_for(0, count, PARALLEL_REAL_CHUNK_SIZE, func);
+    }
+
+    template < class Float, class Parallelizer >
+    void ParallelRealComplexTransform(std::complex<Float> *src, std::complex<Float> *dst, const RealFftPlan<Float> &plan,
+                                      const Parallelizer& parallelizer) {
+        const size_t n = plan.ComplexSize();
+        if (plan.UsesMixedRadix()) {
+            mixed_radix_fft::ImplParallelDFT{}(src, src + n, dst, 1, plan.MixedRadixComplexPlan(), parallelizer);
+        } else {
+            bluestein_fft::ImplParallelDFT{}(src, src + n, dst, 1, plan.BluesteinComplexPlan(), parallelizer);
+        }
+    }
+}; // namespace dft_detail
+
+namespace real_fft {
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelRFFT(InputIt first, InputIt last, OutputIt d_first, const RealFftPlan<Float> &plan,
+                      const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.Size());
+
+        const size_t h = plan.ComplexSize();
+        std::vector<std::complex<Float>> packed(h);
+        dft_detail::ParallelForRealChunks(h, [&](size_t i_first, size_t i_last) {
+            dft_detail::PackReal(first, packed.data(), plan, i_first, i_last);
+        }, parallelizer);
+
+        std::vector<std::complex<Float>> storage;
+        std::complex<Float> *spectrum = dft_detail::RealSpectrumBuffer(d_first, plan, storage);
+
+        dft_detail::ParallelRealComplexTransform(packed.data(), spectrum, plan, parallelizer);
+        dft_detail::ParallelForRealChunks(h / 2 + 1, [&](size_t k_first, size_t k_last) {
+            dft_detail::SplitSpectrum(spectrum, d_first, plan, k_first, k_last);
+        }, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIRFFT(InputIt first, InputIt last, OutputIt d_first, const RealFftPlan<Float> &plan,
+                       const Parallelizer& parallelizer) {
+        assert(plan.IsInverse());
+        assert((size_t) std::distance(first, last) == plan.SpectrumSize());
+
+        const size_t h = plan.ComplexSize();
+        std::vector<std::complex<Float>> spectrum(h), packed(h);
+
+        dft_detail::ParallelForRealChunks(h / 2 + 1, [&](size_t k_first, size_t k_last) {
+            dft_detail::MergeSpectrum(first, spectrum.data(), plan, k_first, k_last);
+        }, parallelizer);
+        dft_detail::ParallelRealComplexTransform(spectrum.data(), packed.data(), plan, parallelizer);
+        dft_detail::ParallelForRealChunks(h, [&](size_t i_first, size_t i_last) {
+            dft_detail::UnpackReal(packed.data(), d_first, plan, i_first, i_last);
+        }, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelRFFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+        using Float = typename ComplexType::value_type;
+
+        const RealFftPlan<Float> plan(std::distance(first, last), false);
+        ParallelRFFT(first, last, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Parallelizer >
+    void ParallelIRFFT(InputIt first, InputIt last, OutputIt d_first, const Parallelizer& parallelizer) {
+        using Float = typename std::iterator_traits<OutputIt>::value_type;
+
+        const RealFftPlan<Float> plan(2 * (std::distance(first, last) - 1), true);
+        ParallelIRFFT(first, last, d_first, plan, parallelizer);
+    }
+}; // namespace real_fft
+
+namespace dft_detail {
+    // Batches of at least PARALLEL_BATCH_MIN_SIZE signals are split across
+    // the threads in chunks of whole signals of about PARALLEL_BATCH_CHUNK_SIZE
+    // elements, each transformed sequentially. Smaller batches transform their
+    // signals one after the other, each in parallel.
+    constexpr size_t PARALLEL_BATCH_MIN_SIZE = 8;
+    constexpr size_t PARALLEL_BATCH_CHUNK_SIZE = size_t{1} << 16;
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelBatch(const BatchLayout &layout, InputIt first, OutputIt d_first, const FftPlan<Float> &plan,
+                       const Parallelizer& parallelizer) {
+        const size_t n = plan.Size();
+
+        if (layout.batch_size < PARALLEL_BATCH_MIN_SIZE) {
+            const size_t input_span = (n - 1) * layout.input_stride + 1;
+            const Float scale = plan.IsInverse() ? (Float) 1 / (Float) n : (Float) 1;
+
+            for (size_t b = 0; b < layout.batch_size; b++) {
+                const InputIt src = first + b * layout.input_distance;
+                const OutputIt dst = d_first + b * layout.output_distance;
+                iterative_fft::ImplParallelDFT{}.template operator()<InputIt, OutputIt, Parallelizer>(src, src + input_span, dst, layout.input_stride, plan, scale, parallelizer);
+            }
+            return;
+        }
+
+        // Whole groups of interleaved signals per chunk.
+        size_t chunk = std::max(size_t{1}, PARALLEL_BATCH_CHUNK_SIZE / n);
+        chunk = (chunk + BATCH_INTERLEAVE_MAX_WIDTH - 1) / BATCH_INTERLEAVE_MAX_WIDTH * BATCH_INTERLEAVE_MAX_WIDTH;
+        const auto task = [&](size_t b_first, size_t b_last) {
+            BatchRange(first, d_first, layout, b_first, b_last, plan);
+        };
+        parallelizer.parallel_for(0, layout.batch_size, chunk, task);
+    }
+}; // namespace dft_detail
+
+namespace batched_fft {
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(const BatchLayout &layout, InputIt first, OutputIt d_first, const FftPlan<Float> &plan,
+                     const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse());
+        dft_detail::ParallelBatch(layout, first, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(const BatchLayout &layout, InputIt first, OutputIt d_first, const FftPlan<Float> &plan,
+                      const Parallelizer& parallelizer) {
+        assert(plan.IsInverse());
+        dft_detail::ParallelBatch(layout, first, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan,
+                     const Parallelizer& parallelizer) {
+        assert(std::distance(first, last) % plan.Size() == 0);
+        ParallelDFT(BatchLayout::Contiguous(std::distance(first, last) / plan.Size(), plan.Size()), first, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const FftPlan<Float> &plan,
+                      const Parallelizer& parallelizer) {
+        assert(std::distance(first, last) % plan.Size() == 0);
+        ParallelIDFT(BatchLayout::Contiguous(std::distance(first, last) / plan.Size(), plan.Size()), first, d_first, plan, parallelizer);
+    }
+}; // namespace batched_fft
+
+namespace dft_detail {
+    // Parallel version of MultiDimAxes. An axis with at least
+    // PARALLEL_BATCH_MIN_SIZE blocks, such as the rows of the planes of a 3D
+    // array, transforms its blocks in parallel, each with its own scratch. An
+    // axis with fewer blocks, such as the first one, uses parallel transposes
+    // and a parallel batch on each block.
+    template < class It, class Float, class Parallelizer >
+    void ParallelMultiDimAxes(It data, const std::vector<size_t> &shape, const MultiDimPlan<Float> &plan,
+                              const Parallelizer& parallelizer) {
+        using ComplexType = typename std::iterator_traits<It>::value_type;
+
+        const int rank = shape.size();
+
+        for (int axis = 0; axis + 1 < rank; axis++) {
+            size_t outer = 1, inner = 1;
+            for (int a = 0; a < axis; a++) {
+                outer *= shape[a];
+            }
+            for (int a = axis + 1; a < rank; a++) {
+                inner *= shape[a];
+            }
+            const size_t length = shape[axis];
+            const FftPlan<Float> &axis_plan = plan.AxisPlan(axis);
+
+            if (inner == 1) {
+                ParallelBatch(BatchLayout::Contiguous(outer, length), data, data, axis_plan, parallelizer);
+            }
+            else if (outer >= PARALLEL_BATCH_MIN_SIZE) {
+                parallelizer.parallel_for(0, outer, 1, [&](size_t o_first, size_t o_last) {
+                    std::vector<ComplexType> scratch(length * inner);
+                    MultiDimAxisBlocks(data, length, inner, o_first, o_last, axis_plan, scratch);
+                });
+            }
+            else {
+                std::vector<ComplexType> scratch(length * inner);
+                for (size_t o = 0; o < outer; o++) {
+                    const It block = data + o * length * inner;
+                    fft_utils::ParallelBlockedTranspose(block, scratch.begin(), length, inner, parallelizer);
+                    ParallelBatch(BatchLayout::Contiguous(inner, length), scratch.begin(), scratch.begin(), axis_plan, parallelizer);
+                    fft_utils::ParallelBlockedTranspose(scratch.begin(), block, inner, length, parallelizer);
+                }
+            }
+        }
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelMultiDim(InputIt first, OutputIt d_first, const MultiDimPlan<Float> &plan,
+                          const Parallelizer& parallelizer) {
+        const size_t n = plan.Shape().back();
+        const size_t rows = plan.Size() / n;
+
+        ParallelBatch(BatchLayout::Contiguous(rows, n), first, d_first, plan.AxisPlan(plan.Rank() - 1), parallelizer);
+        ParallelMultiDimAxes(d_first, plan.Shape(), plan, parallelizer);
+    }
+
+    // Runs func(p_first, p_last) over the pairs of rows of length n of a real
+    // transform, in chunks of about PARALLEL_BATCH_CHUNK_SIZE values.
+    template < class Func, class Parallelizer >
+    void ParallelForPairs(size_t pairs, size_t n, const Func &func, const Parallelizer& parallelizer) {
+        const size_t chunk = std::max(size_t{1}, PARALLEL_BATCH_CHUNK_SIZE / n);
+        parallelizer.parallel_for(0, pairs, chunk, func);
+    }
+}; // namespace dft_detail
+
+namespace multidim_fft {
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan,
+                     const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse() && !plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        dft_detail::ParallelMultiDim(first, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelIDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan,
+                      const Parallelizer& parallelizer) {
+        assert(plan.IsInverse() && !plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.Size());
+        dft_detail::ParallelMultiDim(first, d_first, plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelRealDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan,
+                         const Parallelizer& parallelizer) {
+        assert(!plan.IsInverse() && plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.Size());
+
+        using ComplexType = typename std::iterator_traits<OutputIt>::value_type;
+
+        const size_t n = plan.Shape().back();
+        const size_t rows = plan.Size() / n;
+        const size_t pairs = (rows + 1) / 2;
+
+        std::vector<ComplexType> packed(pairs * n);
+        dft_detail::ParallelForPairs(pairs, n, [&](size_t p_first, size_t p_last) {
+            dft_detail::PairRealRows(first, packed.data(), rows, n, p_first, p_last);
+        }, parallelizer);
+        dft_detail::ParallelBatch(BatchLayout::Contiguous(pairs, n), packed.begin(), packed.begin(), plan.AxisPlan(plan.Rank() - 1), parallelizer);
+        dft_detail::ParallelForPairs(pairs, n, [&](size_t p_first, size_t p_last) {
+            dft_detail::UnpairSpectra(packed.data(), d_first, rows, n, p_first, p_last);
+        }, parallelizer);
+
+        dft_detail::ParallelMultiDimAxes(d_first, plan.SpectrumShape(), plan, parallelizer);
+    }
+
+    template < class InputIt, class OutputIt, class Float, class Parallelizer >
+    void ParallelRealIDFT(InputIt first, InputIt last, OutputIt d_first, const MultiDimPlan<Float> &plan,
+                          const Parallelizer& parallelizer) {
+        assert(plan.IsInverse() && plan.IsRealInput());
+        assert((size_t) std::distance(first, last) == plan.SpectrumSize());
+
+        using ComplexType = typename std::iterator_traits<InputIt>::value_type;
+
+        const size_t n = plan.Shape().back();
+        const size_t rows = plan.Size() / n;
+        const size_t pairs = (rows + 1) / 2;
+
+        std::vector<ComplexType> spectrum(first, last);
+        dft_detail::ParallelMultiDimAxes(spectrum.begin(), plan.SpectrumShape(), plan, parallelizer);
+
+        std::vector<ComplexType> packed(pairs * n);
+        dft_detail::ParallelForPairs(pairs, n, [&](size_t p_first, size_t p_last) {
+            dft_detail::PairHalfSpectra(spectrum.begin(), packed.data(), rows, n, p_first, p_last);
+        }, parallelizer);
+        dft_detail::ParallelBatch(BatchLayout::Contiguous(pairs, n), packed.begin(), packed.begin(), plan.AxisPlan(plan.Rank() - 1), parallelizer);
+        dft_detail::ParallelForPairs(pairs, n, [&](size_t p_first, size_t p_last) {
+            dft_detail::UnpairRealRows(packed.data(), d_first, rows, n, p_first, p_last);
+        }, parallelizer);
+    }
+}; // namespace multidim_fft
 
 
 #endif
\ No newline at end of file
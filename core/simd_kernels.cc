@@ -0,0 +1,484 @@
+#include <core/simd_kernels.h>
+
+#include <atomic>
+#include <immintrin.h>
+
+namespace simd {
+
+namespace {
+
+template < class Float >
+void ScalarRadixTwoStage(std::complex<Float> *data, size_t n, size_t half, const std::complex<Float> *twiddles) {
+    for (size_t k = 0; k < n; k += 2 * half) {
+        for (size_t j = 0; j < half; j++) {
+            const std::complex<Float> a = data[k + j];
+            const std::complex<Float> b = twiddles[j] * data[k + j + half];
+            data[k + j] = a + b;
+            data[k + j + half] = a - b;
+        }
+    }
+}
+
+template < class Float >
+void ScalarRadixTwoColumns(std::complex<Float> *data, size_t half, size_t j_first, size_t j_last,
+                           const std::complex<Float> *twiddles) {
+    for (size_t j = j_first; j < j_last; j++) {
+        const std::complex<Float> a = data[j];
+        const std::complex<Float> b = twiddles[j] * data[j + half];
+        data[j] = a + b;
+        data[j + half] = a - b;
+    }
+}
+
+template < class Float >
+void ScalarStockhamStage(const std::complex<Float> *src, std::complex<Float> *dst, size_t l, size_t m,
+                         size_t j_first, size_t j_last, const std::complex<Float> *twiddles) {
+    const size_t half = l * m;
+    for (size_t j = j_first; j < j_last; j++) {
+        const std::complex<Float> w = twiddles[j];
+        for (size_t k = 0; k < m; k++) {
+            const std::complex<Float> a = src[k + j * m];
+            const std::complex<Float> b = src[k + j * m + half];
+            const std::complex<Float> d = a - b;
+            dst[k + 2 * j * m] = a + b;
+            dst[k + 2 * j * m + m] = std::complex<Float>(w.real() * d.real() - w.imag() * d.imag(),
+                                                         w.real() * d.imag() + w.imag() * d.real());
+        }
+    }
+}
+
+// Complex multiplications of interleaved (re, im) pairs:
+//     (b.re * w.re - b.im * w.im, b.im * w.re + b.re * w.im)
+// fmaddsub subtracts on the even lanes and adds on the odd lanes.
+
+__attribute__((target("avx2,fma")))
+inline __m256d ComplexMultiply(__m256d b, __m256d w) {
+    const __m256d w_re = _mm256_movedup_pd(w);
+    const __m256d w_im = _mm256_permute_pd(w, 0xF);
+    const __m256d b_swapped = _mm256_permute_pd(b, 0x5);
+    return _mm256_fmaddsub_pd(b, w_re, _mm256_mul_pd(b_swapped, w_im));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 ComplexMultiply(__m256 b, __m256 w) {
+    const __m256 w_re = _mm256_moveldup_ps(w);
+    const __m256 w_im = _mm256_movehdup_ps(w);
+    const __m256 b_swapped = _mm256_permute_ps(b, 0xB1);
+    return _mm256_fmaddsub_ps(b, w_re, _mm256_mul_ps(b_swapped, w_im));
+}
+
+// GCC 12 reports the deliberately undefined pass-through operand of the
+// AVX-512 intrinsics as maybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+inline __m512d ComplexMultiply(__m512d b, __m512d w) {
+    const __m512d w_re = _mm512_movedup_pd(w);
+    const __m512d w_im = _mm512_permute_pd(w, 0xFF);
+    const __m512d b_swapped = _mm512_permute_pd(b, 0x55);
+    return _mm512_fmaddsub_pd(b, w_re, _mm512_mul_pd(b_swapped, w_im));
+}
+
+__attribute__((target("avx512f")))
+inline __m512 ComplexMultiply(__m512 b, __m512 w) {
+    const __m512 w_re = _mm512_moveldup_ps(w);
+    const __m512 w_im = _mm512_movehdup_ps(w);
+    const __m512 b_swapped = _mm512_permute_ps(b, 0xB1);
+    return _mm512_fmaddsub_ps(b, w_re, _mm512_mul_ps(b_swapped, w_im));
+}
+
+// The vector kernels process one register of complex numbers per step. half
+// is a power of 2, so when it is at least the register width there is no
+// remainder. Smaller halves (the first stages) use the scalar kernel.
+
+__attribute__((target("avx2,fma")))
+void Avx2RadixTwoStage(std::complex<double> *data, size_t n, size_t half, const std::complex<double> *twiddles) {
+    constexpr size_t lanes = 2;
+    if (half < lanes) {
+        ScalarRadixTwoStage(data, n, half, twiddles);
+        return;
+    }
+
+    const double *w = reinterpret_cast<const double *>(twiddles);
+    for (size_t k = 0; k < n; k += 2 * half) {
+        double *lo = reinterpret_cast<double *>(data + k);
+        double *hi = reinterpret_cast<double *>(data + k + half);
+        for (size_t j = 0; j < 2 * half; j += 2 * lanes) {
+            const __m256d a = _mm256_loadu_pd(lo + j);
+            const __m256d b = ComplexMultiply(_mm256_loadu_pd(hi + j), _mm256_loadu_pd(w + j));
+            _mm256_storeu_pd(lo + j, _mm256_add_pd(a, b));
+            _mm256_storeu_pd(hi + j, _mm256_sub_pd(a, b));
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void Avx2RadixTwoStage(std::complex<float> *data, size_t n, size_t half, const std::complex<float> *twiddles) {
+    constexpr size_t lanes = 4;
+    if (half < lanes) {
+        ScalarRadixTwoStage(data, n, half, twiddles);
+        return;
+    }
+
+    const float *w = reinterpret_cast<const float *>(twiddles);
+    for (size_t k = 0; k < n; k += 2 * half) {
+        float *lo = reinterpret_cast<float *>(data + k);
+        float *hi = reinterpret_cast<float *>(data + k + half);
+        for (size_t j = 0; j < 2 * half; j += 2 * lanes) {
+            const __m256 a = _mm256_loadu_ps(lo + j);
+            const __m256 b = ComplexMultiply(_mm256_loadu_ps(hi + j), _mm256_loadu_ps(w + j));
+            _mm256_storeu_ps(lo + j, _mm256_add_ps(a, b));
+            _mm256_storeu_ps(hi + j, _mm256_sub_ps(a, b));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void Avx512RadixTwoStage(std::complex<double> *data, size_t n, size_t half, const std::complex<double> *twiddles) {
+    constexpr size_t lanes = 4;
+    if (half < lanes) {
+        ScalarRadixTwoStage(data, n, half, twiddles);
+        return;
+    }
+
+    const double *w = reinterpret_cast<const double *>(twiddles);
+    for (size_t k = 0; k < n; k += 2 * half) {
+        double *lo = reinterpret_cast<double *>(data + k);
+        double *hi = reinterpret_cast<double *>(data + k + half);
+        for (size_t j = 0; j < 2 * half; j += 2 * lanes) {
+            const __m512d a = _mm512_loadu_pd(lo + j);
+            const __m512d b = ComplexMultiply(_mm512_loadu_pd(hi + j), _mm512_loadu_pd(w + j));
+            _mm512_storeu_pd(lo + j, _mm512_add_pd(a, b));
+            _mm512_storeu_pd(hi + j, _mm512_sub_pd(a, b));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void Avx512RadixTwoStage(std::complex<float> *data, size_t n, size_t half, const std::complex<float> *twiddles) {
+    constexpr size_t lanes = 8;
+    if (half < lanes) {
+        ScalarRadixTwoStage(data, n, half, twiddles);
+        return;
+    }
+
+    const float *w = reinterpret_cast<const float *>(twiddles);
+    for (size_t k = 0; k < n; k += 2 * half) {
+        float *lo = reinterpret_cast<float *>(data + k);
+        float *hi = reinterpret_cast<float *>(data + k + half);
+        for (size_t j = 0; j < 2 * half; j += 2 * lanes) {
+            const __m512 a = _mm512_loadu_ps(lo + j);
+            const __m512 b = ComplexMultiply(_mm512_loadu_ps(hi + j), _mm512_loadu_ps(w + j));
+            _mm512_storeu_ps(lo + j, _mm512_add_ps(a, b));
+            _mm512_storeu_ps(hi + j, _mm512_sub_ps(a, b));
+        }
+    }
+}
+
+// The column kernels run whole registers from j_first on and leave the last
+// j_last - j_first mod lanes columns to the scalar kernel.
+
+__attribute__((target("avx2,fma")))
+void Avx2RadixTwoColumns(std::complex<double> *data, size_t half, size_t j_first, size_t j_last,
+                         const std::complex<double> *twiddles) {
+    constexpr size_t lanes = 2;
+    const double *w = reinterpret_cast<const double *>(twiddles);
+    double *lo = reinterpret_cast<double *>(data);
+    double *hi = reinterpret_cast<double *>(data + half);
+
+    size_t j = j_first;
+    for (; j + lanes <= j_last; j += lanes) {
+        const __m256d a = _mm256_loadu_pd(lo + 2 * j);
+        const __m256d b = ComplexMultiply(_mm256_loadu_pd(hi + 2 * j), _mm256_loadu_pd(w + 2 * j));
+        _mm256_storeu_pd(lo + 2 * j, _mm256_add_pd(a, b));
+        _mm256_storeu_pd(hi + 2 * j, _mm256_sub_pd(a, b));
+    }
+    ScalarRadixTwoColumns(data, half, j, j_last, twiddles);
+}
+
+__attribute__((target("avx2,fma")))
+void Avx2RadixTwoColumns(std::complex<float> *data, size_t half, size_t j_first, size_t j_last,
+                         const std::complex<float> *twiddles) {
+    constexpr size_t lanes = 4;
+    const float *w = reinterpret_cast<const float *>(twiddles);
+    float *lo = reinterpret_cast<float *>(data);
+    float *hi = reinterpret_cast<float *>(data + half);
+
+    size_t j = j_first;
+    for (; j + lanes <= j_last; j += lanes) {
+        const __m256 a = _mm256_loadu_ps(lo + 2 * j);
+        const __m256 b = ComplexMultiply(_mm256_loadu_ps(hi + 2 * j), _mm256_loadu_ps(w + 2 * j));
+        _mm256_storeu_ps(lo + 2 * j, _mm256_add_ps(a, b));
+        _mm256_storeu_ps(hi + 2 * j, _mm256_sub_ps(a, b));
+    }
+    ScalarRadixTwoColumns(data, half, j, j_last, twiddles);
+}
+
+__attribute__((target("avx512f")))
+void Avx512RadixTwoColumns(std::complex<double> *data, size_t half, size_t j_first, size_t j_last,
+                           const std::complex<double> *twiddles) {
+    constexpr size_t lanes = 4;
+    const double *w = reinterpret_cast<const double *>(twiddles);
+    double *lo = reinterpret_cast<double *>(data);
+    double *hi = reinterpret_cast<double *>(data + half);
+
+    size_t j = j_first;
+    for (; j + lanes <= j_last; j += lanes) {
+        const __m512d a = _mm512_loadu_pd(lo + 2 * j);
+        const __m512d b = ComplexMultiply(_mm512_loadu_pd(hi + 2 * j), _mm512_loadu_pd(w + 2 * j));
+        _mm512_storeu_pd(lo + 2 * j, _mm512_add_pd(a, b));
+        _mm512_storeu_pd(hi + 2 * j, _mm512_sub_pd(a, b));
+    }
+    Avx2RadixTwoColumns(data, half, j, j_last, twiddles);
+}
+
+__attribute__((target("avx512f")))
+void Avx512RadixTwoColumns(std::complex<float> *data, size_t half, size_t j_first, size_t j_last,
+                           const std::complex<float> *twiddles) {
+    constexpr size_t lanes = 8;
+    const float *w = reinterpret_cast<const float *>(twiddles);
+    float *lo = reinterpret_cast<float *>(data);
+    float *hi = reinterpret_cast<float *>(data + half);
+
+    size_t j = j_first;
+    for (; j + lanes <= j_last; j += lanes) {
+        const __m512 a = _mm512_loadu_ps(lo + 2 * j);
+        const __m512 b = ComplexMultiply(_mm512_loadu_ps(hi + 2 * j), _mm512_loadu_ps(w + 2 * j));
+        _mm512_storeu_ps(lo + 2 * j, _mm512_add_ps(a, b));
+        _mm512_storeu_ps(hi + 2 * j, _mm512_sub_ps(a, b));
+    }
+    Avx2RadixTwoColumns(data, half, j, j_last, twiddles);
+}
+
+// The Stockham kernels broadcast the twiddle of group j and run over the m
+// contiguous values of the group. m is a power of 2, so when it is at least
+// the register width there is no remainder.
+
+__attribute__((target("avx2,fma")))
+void Avx2StockhamStage(const std::complex<double> *src, std::complex<double> *dst, size_t l, size_t m,
+                       size_t j_first, size_t j_last, const std::complex<double> *twiddles) {
+    constexpr size_t lanes = 2;
+    if (m < lanes) {
+        ScalarStockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+        return;
+    }
+
+    const size_t half = l * m;
+    for (size_t j = j_first; j < j_last; j++) {
+        const __m256d w = _mm256_broadcast_pd(reinterpret_cast<const __m128d *>(twiddles + j));
+        const double *lo = reinterpret_cast<const double *>(src + j * m);
+        const double *hi = reinterpret_cast<const double *>(src + j * m + half);
+        double *sum = reinterpret_cast<double *>(dst + 2 * j * m);
+        double *diff = reinterpret_cast<double *>(dst + 2 * j * m + m);
+        for (size_t k = 0; k < 2 * m; k += 2 * lanes) {
+            const __m256d a = _mm256_loadu_pd(lo + k);
+            const __m256d b = _mm256_loadu_pd(hi + k);
+            _mm256_storeu_pd(sum + k, _mm256_add_pd(a, b));
+            _mm256_storeu_pd(diff + k, ComplexMultiply(_mm256_sub_pd(a, b), w));
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void Avx2StockhamStage(const std::complex<float> *src, std::complex<float> *dst, size_t l, size_t m,
+                       size_t j_first, size_t j_last, const std::complex<float> *twiddles) {
+    constexpr size_t lanes = 4;
+    if (m < lanes) {
+        ScalarStockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+        return;
+    }
+
+    const size_t half = l * m;
+    for (size_t j = j_first; j < j_last; j++) {
+        const __m256 w = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double *>(twiddles + j)));
+        const float *lo = reinterpret_cast<const float *>(src + j * m);
+        const float *hi = reinterpret_cast<const float *>(src + j * m + half);
+        float *sum = reinterpret_cast<float *>(dst + 2 * j * m);
+        float *diff = reinterpret_cast<float *>(dst + 2 * j * m + m);
+        for (size_t k = 0; k < 2 * m; k += 2 * lanes) {
+            const __m256 a = _mm256_loadu_ps(lo + k);
+            const __m256 b = _mm256_loadu_ps(hi + k);
+            _mm256_storeu_ps(sum + k, _mm256_add_ps(a, b));
+            _mm256_storeu_ps(diff + k, ComplexMultiply(_mm256_sub_ps(a, b), w));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void Avx512StockhamStage(const std::complex<double> *src, std::complex<double> *dst, size_t l, size_t m,
+                         size_t j_first, size_t j_last, const std::complex<double> *twiddles) {
+    constexpr size_t lanes = 4;
+    if (m < lanes) {
+        Avx2StockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+        return;
+    }
+
+    const size_t half = l * m;
+    for (size_t j = j_first; j < j_last; j++) {
+        const __m512d w = _mm512_broadcast_f64x4(_mm256_broadcast_pd(reinterpret_cast<const __m128d *>(twiddles + j)));
+        const double *lo = reinterpret_cast<const double *>(src + j * m);
+        const double *hi = reinterpret_cast<const double *>(src + j * m + half);
+        double *sum = reinterpret_cast<double *>(dst + 2 * j * m);
+        double *diff = reinterpret_cast<double *>(dst + 2 * j * m + m);
+        for (size_t k = 0; k < 2 * m; k += 2 * lanes) {
+            const __m512d a = _mm512_loadu_pd(lo + k);
+            const __m512d b = _mm512_loadu_pd(hi + k);
+            _mm512_storeu_pd(sum + k, _mm512_add_pd(a, b));
+            _mm512_storeu_pd(diff + k, ComplexMultiply(_mm512_sub_pd(a, b), w));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void Avx512StockhamStage(const std::complex<float> *src, std::complex<float> *dst, size_t l, size_t m,
+                         size_t j_first, size_t j_last, const std::complex<float> *twiddles) {
+    constexpr size_t lanes = 8;
+    if (m < lanes) {
+        Avx2StockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+        return;
+    }
+
+    const size_t half = l * m;
+    for (size_t j = j_first; j < j_last; j++) {
+        const __m512 w = _mm512_castpd_ps(_mm512_set1_pd(*reinterpret_cast<const double *>(twiddles + j)));
+        const float *lo = reinterpret_cast<const float *>(src + j * m);
+        const float *hi = reinterpret_cast<const float *>(src + j * m + half);
+        float *sum = reinterpret_cast<float *>(dst + 2 * j * m);
+        float *diff = reinterpret_cast<float *>(dst + 2 * j * m + m);
+        for (size_t k = 0; k < 2 * m; k += 2 * lanes) {
+            const __m512 a = _mm512_loadu_ps(lo + k);
+            const __m512 b = _mm512_loadu_ps(hi + k);
+            _mm512_storeu_ps(sum + k, _mm512_add_ps(a, b));
+            _mm512_storeu_ps(diff + k, ComplexMultiply(_mm512_sub_ps(a, b), w));
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+std::atomic<InstructionSet> &ActiveInstructionSetStorage() {
+    static std::atomic<InstructionSet> instruction_set{DetectInstructionSet()};
+    return instruction_set;
+}
+
+}; // namespace
+
+InstructionSet DetectInstructionSet() {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        return InstructionSet::kAvx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return InstructionSet::kAvx2;
+    }
+    return InstructionSet::kScalar;
+}
+
+InstructionSet ActiveInstructionSet() {
+    return ActiveInstructionSetStorage().load(std::memory_order_relaxed);
+}
+
+void SetInstructionSet(InstructionSet instruction_set) {
+    const InstructionSet supported = DetectInstructionSet();
+    if (static_cast<int>(instruction_set) > static_cast<int>(supported)) {
+        instruction_set = supported;
+    }
+    ActiveInstructionSetStorage().store(instruction_set, std::memory_order_relaxed);
+}
+
+const char *InstructionSetName(InstructionSet instruction_set) {
+    switch (instruction_set) {
+        case InstructionSet::kAvx512:
+            return "AVX-512";
+        case InstructionSet::kAvx2:
+            return "AVX2";
+        default:
+            return "Scalar";
+    }
+}
+
+void RadixTwoStage(std::complex<double> *data, size_t n, size_t half, const std::complex<double> *twiddles) {
+    switch (ActiveInstructionSet()) {
+        case InstructionSet::kAvx512:
+            Avx512RadixTwoStage(data, n, half, twiddles);
+            break;
+        case InstructionSet::kAvx2:
+            Avx2RadixTwoStage(data, n, half, twiddles);
+            break;
+        default:
+            ScalarRadixTwoStage(data, n, half, twiddles);
+    }
+}
+
+void RadixTwoStage(std::complex<float> *data, size_t n, size_t half, const std::complex<float> *twiddles) {
+    switch (ActiveInstructionSet()) {
+        case InstructionSet::kAvx512:
+            Avx512RadixTwoStage(data, n, half, twiddles);
+            break;
+        case InstructionSet::kAvx2:
+            Avx2RadixTwoStage(data, n, half, twiddles);
+            break;
+        default:
+            ScalarRadixTwoStage(data, n, half, twiddles);
+    }
+}
+
+void RadixTwoStage(std::complex<double> *data, size_t half, size_t j_first, size_t j_last,
+                   const std::complex<double> *twiddles) {
+    switch (ActiveInstructionSet()) {
+        case InstructionSet::kAvx512:
+            Avx512RadixTwoColumns(data, half, j_first, j_last, twiddles);
+            break;
+        case InstructionSet::kAvx2:
+            Avx2RadixTwoColumns(data, half, j_first, j_last, twiddles);
+            break;
+        default:
+            ScalarRadixTwoColumns(data, half, j_first, j_last, twiddles);
+    }
+}
+
+void RadixTwoStage(std::complex<float> *data, size_t half, size_t j_first, size_t j_last,
+                   const std::complex<float> *twiddles) {
+    switch (ActiveInstructionSet()) {
+        case InstructionSet::kAvx512:
+            Avx512RadixTwoColumns(data, half, j_first, j_last, twiddles);
+            break;
+        case InstructionSet::kAvx2:
+            Avx2RadixTwoColumns(data, half, j_first, j_last, twiddles);
+            break;
+        default:
+            ScalarRadixTwoColumns(data, half, j_first, j_last, twiddles);
+    }
+}
+
+void StockhamStage(const std::complex<double> *src, std::complex<double> *dst, size_t l, size_t m,
+                   size_t j_first, size_t j_last, const std::complex<double> *twiddles) {
+    switch (ActiveInstructionSet()) {
+        case InstructionSet::kAvx512:
+            Avx512StockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+            break;
+        case InstructionSet::kAvx2:
+            Avx2StockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+            break;
+        default:
+            ScalarStockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+    }
+}
+
+void StockhamStage(const std::complex<float> *src, std::complex<float> *dst, size_t l, size_t m,
+                   size_t j_first, size_t j_last, const std::complex<float> *twiddles) {
+    switch (ActiveInstructionSet()) {
+        case InstructionSet::kAvx512:
+            Avx512StockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+            break;
+        case InstructionSet::kAvx2:
+            Avx2StockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+            break;
+        default:
+            ScalarStockhamStage(src, dst, l, m, j_first, j_last, twiddles);
+    }
+}
+
+}; // namespace simd
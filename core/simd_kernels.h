@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef CORE_SIMD_KERNELS_H
+#define CORE_SIMD_KERNELS_H
+
+#include <complex>
+#include <cstddef>
+
+/// Vectorized butterfly kernels for float and double.
+///
+/// The instruction set is detected once at runtime. Every kernel has an AVX-512,
+/// an AVX2 (+FMA) and a scalar version, so the library runs on any x86-64 CPU
+/// without special compiler flags.
+namespace simd {
+
+enum class InstructionSet {
+    kScalar,
+    kAvx2,
+    kAvx512,
+};
+
+/// Best instruction set supported by the CPU.
+InstructionSet DetectInstructionSet();
+
+/// Instruction set currently used by the kernels.
+InstructionSet ActiveInstructionSet();
+
+/// Forces the kernels to use instruction_set. Requests for an instruction set
+/// the CPU does not support fall back to the best supported one. Used by the
+/// benchmarks to compare the code paths.
+void SetInstructionSet(InstructionSet instruction_set);
+
+const char *InstructionSetName(InstructionSet instruction_set);
+
+/// One radix 2 stage of the iterative FFT over data[0...n).
+/// For every block of length 2*half and every j < half:
+///     b = twiddles[j] * data[k + j + half]
+///     data[k + j] = data[k + j] + b
+///     data[k + j + half] = data[k + j] - b
+void RadixTwoStage(std::complex<double> *data, size_t n, size_t half, const std::complex<double> *twiddles);
+void RadixTwoStage(std::complex<float> *data, size_t n, size_t half, const std::complex<float> *twiddles);
+
+/// The columns j in [j_first, j_last) of one radix 2 stage on the single
+/// block data[0...2*half). The parallel passes split the few large blocks of
+/// the last stages this way between their threads.
+void RadixTwoStage(std::complex<double> *data, size_t half, size_t j_first, size_t j_last,
+                   const std::complex<double> *twiddles);
+void RadixTwoStage(std::complex<float> *data, size_t half, size_t j_first, size_t j_last,
+                   const std::complex<float> *twiddles);
+
+/// One radix 2 stage of the Stockham auto-sort FFT from src to dst, see
+/// dft_detail::StockhamStage. For j in [j_first, j_last) and k < m:
+///     dst[k + 2jm]     = src[k + jm] + src[k + jm + lm]
+///     dst[k + 2jm + m] = twiddles[j] * (src[k + jm] - src[k + jm + lm])
+void StockhamStage(const std::complex<double> *src, std::complex<double> *dst, size_t l, size_t m,
+                   size_t j_first, size_t j_last, const std::complex<double> *twiddles);
+void StockhamStage(const std::complex<float> *src, std::complex<float> *dst, size_t l, size_t m,
+                   size_t j_first, size_t j_last, const std::complex<float> *twiddles);
+
+}; // namespace simd
+
+#endif
@@ -2,33 +2,17 @@
 #include <vector>
 #include <string.h>
 
-int main(int argc, char **argv) {
-
-    char mode = 'd';
-
-    if (argc != 1) {
-        if (argc != 2  || strlen(argv[1]) != 1) {
-            printf("Usage: %s [MODE]\n", argv[0]);
-            printf("\t [MODE] (optional) can take the following values:\n");
-            printf("\t\t `d` (default) for the DFT transformation\n");
-            printf("\t\t `i` for the inverse dft transformation\n");
-            exit(1);
-        }
-
-        mode = argv[1][0];
-        if (mode != 'd' && mode != 'i') {
-            printf("Invalid mode.\n");
-            exit(1);
-        }
-    }
+template < class Float >
+static void Run(char mode) {
+    using Complex = ComplexOf<Float>;
 
     size_t N;
 
-    printf("Write the size of your sequence (must be a power of 2): ");
+    printf("Write the size of your sequence: ");
     std::cin >> N;
 
-    if (!fft_utils::IsPowerOfTwo(N)) {
-        printf("ERROR: Your sequence size is not a power of 2.\n");
+    if (N == 0) {
+        printf("ERROR: the size of the sequence must be positive.\n");
         exit(1);
     }
 
@@ -39,19 +23,31 @@ int main(int argc, char **argv) {
         std::cin >> data[i];
     }
 
-    std::cout << "Your data is:\n"; 
+    std::cout << "Your data is:\n";
     for (size_t i = 0; i < N; i++) {
         std::cout << data[i] << "\n";
     }
 
     std::cout << "\n";
 
+    // Sizes with prime factors 2, 3, 5 and 7 use the mixed radix engine,
+    // every other size goes through Bluestein's algorithm.
+    const bool is_smooth = fft_utils::IsSmooth(N);
+
     if (mode == 'd') {
-        iterative_fft::ParallelDFT(data.begin(), data.end(), data.begin(), FixedThreadsParallelizer{});
+        if (is_smooth) {
+            mixed_radix_fft::ParallelDFT(data.begin(), data.end(), data.begin(), FixedThreadsParallelizer{});
+        } else {
+            bluestein_fft::ParallelDFT(data.begin(), data.end(), data.begin(), FixedThreadsParallelizer{});
+        }
     }
 
     if (mode == 'i') {
-        iterative_fft::ParallelIDFT(data.begin(), data.end(), data.begin(), FixedThreadsParallelizer{});
+        if (is_smooth) {
+            mixed_radix_fft::ParallelIDFT(data.begin(), data.end(), data.begin(), FixedThreadsParallelizer{});
+        } else {
+            bluestein_fft::ParallelIDFT(data.begin(), data.end(), data.begin(), FixedThreadsParallelizer{});
+        }
     }
 
     std::string transform;
@@ -65,5 +61,48 @@ int main(int argc, char **argv) {
     for (size_t i = 0; i < N; i++) {
         std::cout << data[i] << "\n";
     }
+}
 
-}
\ No newline at end of file
+int main(int argc, char **argv) {
+
+    char mode = 'd';
+    char precision = 'l';
+
+    if (argc != 1) {
+        if (argc > 3 || strlen(argv[1]) != 1 || (argc == 3 && strlen(argv[2]) != 1)) {
+            printf("Usage: %s [MODE] [PRECISION]\n", argv[0]);
+            printf("\t [MODE] (optional) can take the following values:\n");
+            printf("\t\t `d` (default) for the DFT transformation\n");
+            printf("\t\t `i` for the inverse dft transformation\n");
+            printf("\t [PRECISION] (optional) can take the following values:\n");
+            printf("\t\t `f` for float\n");
+            printf("\t\t `d` for double\n");
+            printf("\t\t `l` (default) for long double\n");
+            exit(1);
+        }
+
+        mode = argv[1][0];
+        if (mode != 'd' && mode != 'i') {
+            printf("Invalid mode.\n");
+            exit(1);
+        }
+
+        if (argc == 3) {
+            precision = argv[2][0];
+        }
+    }
+
+    if (precision == 'f') {
+        Run<float>(mode);
+    }
+    else if (precision == 'd') {
+        Run<double>(mode);
+    }
+    else if (precision == 'l') {
+        Run<long double>(mode);
+    }
+    else {
+        printf("Invalid precision.\n");
+        exit(1);
+    }
+}
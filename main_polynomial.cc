@@ -5,15 +5,20 @@
 #include <string.h>
 
 int main(int argc, char **argv) {
-    if (argc != 2 || strlen(argv[1]) != 1) {
-        printf("Usage: %s [MODE]\n", argv[0]);
+    if (argc < 2 || argc > 3 || strlen(argv[1]) != 1 || (argc == 3 && strlen(argv[2]) != 1)) {
+        printf("Usage: %s [MODE] [PRECISION]\n", argv[0]);
         printf("\t [MODE] can take the following values:\n");
         printf("\t\t `i` for integer polynomial multiplication\n");
         printf("\t\t `r` for real polynomial multiplication\n");
+        printf("\t [PRECISION] (optional, real mode only) can take the following values:\n");
+        printf("\t\t `f` for float\n");
+        printf("\t\t `d` for double\n");
+        printf("\t\t `l` (default) for long double\n");
         exit(1);
     }
 
     char mode = argv[1][0];
+    char precision = (argc == 3) ? argv[2][0] : 'l';
 
     auto write_polynomial = [](auto &P) {
         for (size_t i = 0; i <= P.Degree(); i++) {
@@ -71,9 +76,12 @@ int main(int argc, char **argv) {
         write_polynomial(AB);
     }
 
-    if (mode == 'r') {
+    // The argument only carries the precision of the computation
+    auto real_multiply = [&](auto zero) {
+        using Float = decltype(zero);
+
         size_t deg_A, deg_B;
-        Polynomial<FloatType> A, B;
+        Polynomial<Float> A, B;
 
 
         std::cout << "Type the degree of the first polynomial: ";
@@ -94,10 +102,26 @@ int main(int argc, char **argv) {
         std::cout << "Your second polynomial is:\n";
         write_polynomial(B);
 
-        auto AB = RealMultiply(A, B);
+        auto AB = RealMultiply<Float>(A, B);
 
         std::cout << "The output polynomial is:\n";
         write_polynomial(AB);
+    };
+
+    if (mode == 'r') {
+        if (precision == 'f') {
+            real_multiply(0.0f);
+        }
+        else if (precision == 'd') {
+            real_multiply(0.0);
+        }
+        else if (precision == 'l') {
+            real_multiply(0.0L);
+        }
+        else {
+            printf("Invalid precision.\n");
+            exit(1);
+        }
     }
 
 }
\ No newline at end of file
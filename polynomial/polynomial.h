@@ -136,8 +136,8 @@ public:
         return Polynomial(new_coefs);
     }
 
-    template < class T1, class T2 >
-    friend Polynomial<Complex> ComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B);
+    template < class Float, class T1, class T2 >
+    friend Polynomial<ComplexOf<Float>> ComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B);
 };
 
 template <typename TypeFrom, typename TypeTo>
@@ -160,20 +160,23 @@ Polynomial<T> operator*(T value, const Polynomial<T> &other) {
 }
 
 // Multiplication
-template < class T1, class T2 >
-Polynomial<Complex> NaiveMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
+// Float is the precision of the complex output. It defaults to FloatType.
+template < class Float = FloatType, class T1, class T2 >
+Polynomial<ComplexOf<Float>> NaiveMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
     const size_t degree_A = A.Degree();
     const size_t degree_B = B.Degree();
     
     // A * B has degree = degree_A + degree_B or 0 if one of the polynomials is 0.
     const size_t degree_product = degree_A + degree_B;
 
+    using Complex = ComplexOf<Float>;
+
     std::vector<Complex> coefs_AB(degree_product + 1);
 
     for (size_t k=0; k <= degree_product; k++) {
         coefs_AB[k] = 0;
         for (size_t l = 0; l <= k; l++) {
-            coefs_AB[k] += A[l] * B[k-l];
+            coefs_AB[k] += (Complex) A[l] * (Complex) B[k-l];
         }
     }
 
@@ -200,14 +203,22 @@ Polynomial<T> NaiveMultiply(const Polynomial<T> &A, const Polynomial<T> &B) {
     return Polynomial<T>(coefs_AB);
 }
 
-template < class T1, class T2 >
-Polynomial<Complex> ComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
+/// Multiplies A*B with complex FFTs computed in precision Float, as a task
+/// graph on the shared pool of the library: the transforms of A and B run
+/// as two independent tasks, and the pointwise product and the inverse
+/// transform as a third task once both are done. Returns at once, except
+/// for small degrees, whose product is computed on the calling thread.
+template < class Float = FloatType, class T1, class T2 >
+fft_async::Future<Polynomial<ComplexOf<Float>>> AsyncComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
+
+    using Complex = ComplexOf<Float>;
 
     const size_t degree_A = A.Degree();
     const size_t degree_B = B.Degree();
 
     if (degree_A <= LIMIT_NAIVE_MULTIPLY || degree_B <= LIMIT_NAIVE_MULTIPLY) {
-        return NaiveMultiply<T1, T2>(A, B);
+        // Too small to gain anything from the pool
+        return fft_async::Ready(NaiveMultiply<Float, T1, T2>(A, B));
     }
 
     // A * B has degree = degree_A + degree_B or 0 if one of the polynomials is 0.
@@ -216,9 +227,6 @@ Polynomial<Complex> ComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2
     // Next power of 2 after degree_product
     size_t N = (1 << (fft_utils::IntLog2(degree_product) + 1));
 
-    std::vector<Complex> rep_A(N);
-    std::vector<Complex> rep_B(N);
-
     // Sequential Version of the code:
     // std::fill(rep_A.begin(), rep_A.end(), (Complex) 0);
     // std::fill(rep_B.begin(), rep_B.end(), (Complex) 0);
@@ -230,47 +238,128 @@ Polynomial<Complex> ComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2
     // iterative_fft::DFT(rep_A.begin(), rep_A.end(), rep_A.begin());
     // iterative_fft::DFT(rep_B.begin(), rep_B.end(), rep_B.begin());
 
+    // The buffers are shared by the tasks of the graph, which outlive this call.
+    // The transforms read the zero padded coefficients directly, which avoids
+    // the N element scratch buffer of an in-place transform.
+    auto coefs_A = std::make_shared<std::vector<T1>>(A.ConstBegin(), A.ConstEnd());
+    auto coefs_B = std::make_shared<std::vector<T2>>(B.ConstBegin(), B.ConstEnd());
+    coefs_A->resize(N);
+    coefs_B->resize(N);
+
+    auto rep_A = std::make_shared<std::vector<Complex>>(N);
+    auto rep_B = std::make_shared<std::vector<Complex>>(N);
+
+    // Both transforms share the same tables
+    auto plan = std::make_shared<const FftPlan<Float>>(N, false);
+
     // Perform the 2 FFTs in parallel (~2x Faster)
-    FixedThreadsParallelizer parallelizer(2);
+    auto transform_A = fft_async::Async([coefs_A, rep_A, plan](){
+        iterative_fft::DFT(coefs_A->begin(), coefs_A->end(), rep_A->begin(), *plan);
+        std::vector<T1>().swap(*coefs_A);
+    });
+    auto transform_B = fft_async::Async([coefs_B, rep_B, plan](){
+        iterative_fft::DFT(coefs_B->begin(), coefs_B->end(), rep_B->begin(), *plan);
+        std::vector<T2>().swap(*coefs_B);
+    });
+
+    return fft_async::WhenAll(transform_A, transform_B).then([rep_A, rep_B, N, degree_product](){
+        // Multiply A * B in values domain, with the 1/N of the inverse transform
+        // folded in. The product is stored in rep_A.
+        const Float inverse_size = (Float) 1 / (Float) N;
+        std::vector<Complex> &rep_AB = *rep_A;
+        std::transform(rep_A->begin(), rep_A->end(), rep_B->begin(), rep_AB.begin(), 
+                        [inverse_size](Complex a, Complex b){ return a * b * inverse_size; });
+        std::vector<Complex>().swap(*rep_B);
+        
+        // Inverse transform, in place and without a second normalization
+        iterative_fft::IDFT(rep_AB.begin(), rep_AB.end(), rep_AB.begin(), FftPlan<Float>(N, true), FftNormalization::kNone);
+        
+        // Only keep the first deg_A + deg_B coefficients
+        rep_AB.erase(rep_AB.begin() + degree_product + 1, rep_AB.end());
+
+        return Polynomial<Complex>(rep_AB);
+    });
+}
 
-    auto TransformA = [&](){
-        std::fill(rep_A.begin(), rep_A.end(), (Complex) 0);
-        std::copy(A.ConstBegin(), A.ConstEnd(), rep_A.begin());
-        iterative_fft::DFT(rep_A.begin(), rep_A.end(), rep_A.begin());
-    };
+/// Multiplies A*B with complex FFTs computed in precision Float.
+template < class Float = FloatType, class T1, class T2 >
+Polynomial<ComplexOf<Float>> ComplexMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
+    return AsyncComplexMultiply<Float>(A, B).get();
+}
 
-    auto TransformB = [&](){
-        std::fill(rep_B.begin(), rep_B.end(), (Complex) 0);
-        std::copy(B.ConstBegin(), B.ConstEnd(), rep_B.begin());
-        iterative_fft::DFT(rep_B.begin(), rep_B.end(), rep_B.begin());
-    };
+// Product of two polynomials with real coefficients, with real transforms
+// of half the size, see RealFftPlan.
+template < class Float, class T1, class T2 >
+Polynomial<Float> RealFftMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
 
-    std::vector<std::function<void(void)>> tasks = {TransformA, TransformB};
-    parallelizer.parallel_calls(tasks);
+    using Complex = ComplexOf<Float>;
+
+    // A * B has degree = degree_A + degree_B
+    const size_t degree_product = A.Degree() + B.Degree();
+
+    // Next power of 2 after degree_product
+    const size_t N = (1 << (fft_utils::IntLog2(degree_product) + 1));
 
-    // Multiply A * B in values domain
-    std::vector<Complex> rep_AB(N);
+    std::vector<Complex> rep_A(N / 2 + 1);
+    std::vector<Complex> rep_B(N / 2 + 1);
+
+    {
+        // Both transforms share the same tables
+        const RealFftPlan<Float> plan(N, false);
+
+        // Perform the 2 FFTs in parallel
+        const ThreadPoolParallelizer &parallelizer = ThreadPoolParallelizer::Shared();
+
+        auto TransformA = [&](){
+            std::vector<Float> coefs_A(A.ConstBegin(), A.ConstEnd());
+            coefs_A.resize(N);
+            real_fft::RFFT(coefs_A.begin(), coefs_A.end(), rep_A.begin(), plan);
+        };
+
+        auto TransformB = [&](){
+            std::vector<Float> coefs_B(B.ConstBegin(), B.ConstEnd());
+            coefs_B.resize(N);
+            real_fft::RFFT(coefs_B.begin(), coefs_B.end(), rep_B.begin(), plan);
+        };
+
+        std::vector<std::function<void(void)>> tasks = {TransformA, TransformB};
+        parallelizer.parallel_calls(tasks);
+    }
+
+    // Multiply A * B on the half spectrum, the product of the conjugates is
+    // the conjugate of the product. The product is stored in rep_A.
+    std::vector<Complex> &rep_AB = rep_A;
     std::transform(rep_A.begin(), rep_A.end(), rep_B.begin(), rep_AB.begin(), 
                     [](Complex a, Complex b){ return a * b; });
-    
-    // Inverse transform
-    iterative_fft::IDFT(rep_AB.begin(), rep_AB.end(), rep_AB.begin());
-    
+    std::vector<Complex>().swap(rep_B);
+
+    PolynomialCoefficients<Float> coefs_AB(N);
+    real_fft::IRFFT(rep_AB.begin(), rep_AB.end(), coefs_AB.begin(), RealFftPlan<Float>(N, true));
+
     // Only keep the first deg_A + deg_B coefficients
-    rep_AB.erase(rep_AB.begin() + degree_product + 1, rep_AB.end());
+    coefs_AB.erase(coefs_AB.begin() + degree_product + 1, coefs_AB.end());
 
-    return Polynomial<Complex>(rep_AB);
+    return Polynomial<Float>(coefs_AB);
 }
 
-template < class T1, class T2 >
-Polynomial<FloatType> RealMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
-    Polynomial<Complex> AB = ComplexMultiply(A, B);
-    PolynomialCoefficients<FloatType> coefs_AB(AB.Degree() + 1);
+/// Multiplies A*B with FFTs computed in precision Float and keeps the real part.
+/// Real coefficients go through real transforms of half the size.
+template < class Float = FloatType, class T1, class T2 >
+Polynomial<Float> RealMultiply(const Polynomial<T1> &A, const Polynomial<T2> &B) {
+
+    if constexpr (std::is_arithmetic<T1>::value && std::is_arithmetic<T2>::value) {
+        if (A.Degree() > LIMIT_NAIVE_MULTIPLY && B.Degree() > LIMIT_NAIVE_MULTIPLY) {
+            return RealFftMultiply<Float>(A, B);
+        }
+    }
+
+    Polynomial<ComplexOf<Float>> AB = ComplexMultiply<Float>(A, B);
+    PolynomialCoefficients<Float> coefs_AB(AB.Degree() + 1);
     for (size_t k = 0; k <= AB.Degree(); k++) {
         coefs_AB[k] = AB[k].real();
     }
 
-    return Polynomial<FloatType>(coefs_AB);
+    return Polynomial<Float>(coefs_AB);
 }
 
 /// Multiplies A*B (mod p).
@@ -304,17 +393,18 @@ Polynomial<nt::Integer> ModularMultiply(const Polynomial<nt::Integer> &A, const
 
     std::vector<nt::Integer> values_A(N), values_B(N);
 
-    const nt::Integer g = nt::PrimitiveRootModPrime(p);
+    // The root and the twiddles of (p, N) are only computed by the first call
+    const auto plan = NttPlan::Cached(p, N);
 
     // Perform the 2 FFTs in parallel
-    FixedThreadsParallelizer parallelizer(2);
+    const ThreadPoolParallelizer &parallelizer = ThreadPoolParallelizer::Shared();
 
     auto TransformA = [&](){
-        ModularFftTransform(coefs_A.begin(), coefs_A.end(), values_A.begin(), p, g);
+        ModularFftTransform(coefs_A.begin(), coefs_A.end(), values_A.begin(), *plan);
     };
 
     auto TransformB = [&](){
-        ModularFftTransform(coefs_B.begin(), coefs_B.end(), values_B.begin(), p, g);
+        ModularFftTransform(coefs_B.begin(), coefs_B.end(), values_B.begin(), *plan);
     };
 
     // Evaluate Polynomials A and B at Nth roots of unity mod p
@@ -322,8 +412,9 @@ Polynomial<nt::Integer> ModularMultiply(const Polynomial<nt::Integer> &A, const
     parallelizer.parallel_calls(tasks);
 
 
-    const auto mul = [p](nt::Integer a, nt::Integer b) {
-        return (a * b) % p;
+    const modular_fft_detail::MontgomeryModulus &mod = plan->Modulus();
+    const auto mul = [&mod](nt::Integer a, nt::Integer b) {
+        return (nt::Integer) mod.mul_mod(a, b);
     };
 
     // Evaluate Polynomial AB at the same points (point-wise multiplication of values_A, values_B)
@@ -332,7 +423,7 @@ Polynomial<nt::Integer> ModularMultiply(const Polynomial<nt::Integer> &A, const
 
     // Do Langrange interpolation to recover the coefficients of AB
     std::vector<nt::Integer> coefs_AB(N);
-    ModularFftInverseTransform(values_AB.begin(), values_AB.end(), coefs_AB.begin(), p, g);
+    ModularFftInverseTransform(values_AB.begin(), values_AB.end(), coefs_AB.begin(), *plan);
 
     return Polynomial<nt::Integer>(coefs_AB);
 }
@@ -365,21 +456,26 @@ Polynomial<nt::Integer> IntegerMultiply(const Polynomial<nt::Integer> &A, const
         // polynomials[i] = ModularMultiply(A, B, primes[i]);
     }
 
-    FixedThreadsParallelizer parallelizer{};
+    // The nested calls of ModularMultiply take the workers of the pool that
+    // this call leaves idle
+    const ThreadPoolParallelizer &parallelizer = ThreadPoolParallelizer::Shared();
     parallelizer.parallel_calls(tasks);
 
     // Now we recover the int coefficients from the CRT
     std::vector<nt::Integer> out_coefficients(degree_output + 1);
-    auto find_coefficient = [&](int k) {
+    auto find_coefficients = [&](size_t k_first, size_t k_last) {
         std::vector<nt::Integer> remainders(n_moduli);
-        for (size_t i = 0; i < n_moduli; i++) {
-            remainders[i] = polynomials[i][k];
-        } 
+        for (size_t k = k_first; k < k_last; k++) {
+            for (size_t i = 0; i < n_moduli; i++) {
+                remainders[i] = polynomials[i][k];
+            } 
 
-        out_coefficients[k] = nt::ChineseRemainderTheorem(remainders, primes);
+            out_coefficients[k] = nt::ChineseRemainderTheorem(remainders, primes);
+        }
     };
 
-    parallelizer.parallel_for(0, degree_output + 1, find_coefficient);
+    constexpr size_t grain = 1 << 10;
+    parallelizer.parallel_for(0, degree_output + 1, grain, find_coefficients);
 
     // Sequential Version
     // for (size_t k = 0; k <= degree_output; k++) {
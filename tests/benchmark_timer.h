@@ -30,4 +30,10 @@ private:
 void timeFunction(std::function<void()> f, std::string title = ""){
     Timer timer = Timer(title);
     f();
-}
\ No newline at end of file
+}
+double measureSeconds(std::function<void()> f){
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    f();
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - startTime;
+    return duration.count();
+}
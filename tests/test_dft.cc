@@ -108,7 +108,7 @@ void TestParallelDFT(size_t N) {
         x[i] = (rand() % 2*max_val) - max_val;
     }
 
-    std::vector<Complex> d01(N), d02(N), d03(N), d11(N), d12(N), d13(N), d_seq1(N), d_seq2(N), d_seq3(N);
+    std::vector<Complex> d01(N), d02(N), d03(N), d11(N), d12(N), d13(N), d22(N), d_seq1(N), d_seq2(N), d_seq3(N);
 
     auto func_seq1 = [&](){ base_dft::DFT(x.begin(), x.end(), d_seq1.begin()); };
     auto func_seq2 = [&](){ recursive_fft::DFT(x.begin(), x.end(), d_seq2.begin()); };
@@ -122,6 +122,8 @@ void TestParallelDFT(size_t N) {
     auto func12 = [&](){ recursive_fft::ParallelDFT(x.begin(), x.end(), d12.begin(), OmpParallelizer());};
     auto func13 = [&](){ iterative_fft::ParallelDFT(x.begin(), x.end(), d13.begin(), OmpParallelizer());};
 
+    auto func22 = [&](){ recursive_fft::ParallelDFT(x.begin(), x.end(), d22.begin(), WorkStealingParallelizer::Shared());};
+
     timeFunction(func_seq1, "Base - sequential");
     timeFunction(func_seq2, "Recursive - sequential");
     timeFunction(func_seq3, "Iterative - sequential");
@@ -134,6 +136,7 @@ void TestParallelDFT(size_t N) {
     timeFunction(func12, "Omp Recursive - parallel  ");
     timeFunction(func13, "Omp Iterative - parallel  ");
 
+    timeFunction(func22, "Work Stealing Recursive - parallel  ");
 
     assert(checkIsClose(d01.data(), d_seq3.data(), N));
     assert(checkIsClose(d02.data(), d_seq3.data(), N));
@@ -142,6 +145,12 @@ void TestParallelDFT(size_t N) {
     assert(checkIsClose(d11.data(), d_seq3.data(), N));
     assert(checkIsClose(d12.data(), d_seq3.data(), N));
     assert(checkIsClose(d13.data(), d_seq3.data(), N));
+
+    assert(checkIsClose(d22.data(), d_seq3.data(), N));
+
+    // More workers than cores, so that tasks are stolen
+    recursive_fft::ParallelDFT(x.begin(), x.end(), d22.begin(), WorkStealingParallelizer(8));
+    assert(checkIsClose(d22.data(), d_seq3.data(), N));
 }
 
 void CompareParallelDFT(size_t N) {
@@ -152,7 +161,7 @@ void CompareParallelDFT(size_t N) {
         x[i] = (rand() % 2*max_val) - max_val;
     }
 
-    std::vector<Complex> d01(N), d02(N), d03(N), d11(N), d12(N), d13(N), d_seq1(N), d_seq2(N), d_seq3(N);
+    std::vector<Complex> d02(N), d03(N), d12(N), d13(N), d22(N), d_seq2(N), d_seq3(N);
 
     auto func_seq2 = [&](){ recursive_fft::DFT(x.begin(), x.end(), d_seq2.begin()); };
     auto func_seq3 = [&](){ iterative_fft::DFT(x.begin(), x.end(), d_seq3.begin()); };
@@ -163,6 +172,8 @@ void CompareParallelDFT(size_t N) {
     auto func12 = [&](){ recursive_fft::ParallelDFT(x.begin(), x.end(), d12.begin(), OmpParallelizer());};
     auto func13 = [&](){ iterative_fft::ParallelDFT(x.begin(), x.end(), d13.begin(), OmpParallelizer());};
 
+    auto func22 = [&](){ recursive_fft::ParallelDFT(x.begin(), x.end(), d22.begin(), WorkStealingParallelizer::Shared());};
+
     timeFunction(func_seq2, "Recursive - sequential");
     timeFunction(func_seq3, "Iterative - sequential");
 
@@ -171,6 +182,906 @@ void CompareParallelDFT(size_t N) {
 
     timeFunction(func12, "Omp Recursive - parallel  ");
     timeFunction(func13, "Omp Iterative - parallel  ");
+
+    timeFunction(func22, "Work Stealing Recursive - parallel  ");
+}
+
+void TestFftPlan(size_t N, size_t repetitions) {
+    constexpr FloatType max_val = 1000;
+
+    std::vector<Complex> x(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    std::vector<Complex> d_ref(N), d1(N), d2(N), d3(N), d4(N);
+    iterative_fft::DFT(x.begin(), x.end(), d_ref.begin());
+
+    const FftPlan<FloatType> forward_plan(N, false);
+    const FftPlan<FloatType> inverse_plan(N, true);
+
+    auto func1 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d1.begin());
+        }
+    };
+    auto func2 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d2.begin(), forward_plan);
+        }
+    };
+    auto func3 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            recursive_fft::DFT(x.begin(), x.end(), d3.begin(), forward_plan);
+        }
+    };
+    auto func4 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::ParallelDFT(x.begin(), x.end(), d4.begin(), forward_plan, OmpParallelizer());
+        }
+    };
+
+    timeFunction(func1, "Iterative - without plan");
+    timeFunction(func2, "Iterative - with plan");
+    timeFunction(func3, "Recursive - with plan");
+    timeFunction(func4, "Omp Iterative - with plan");
+
+    assert(checkIsClose(d1.data(), d_ref.data(), N));
+    assert(checkIsClose(d2.data(), d_ref.data(), N));
+    assert(checkIsClose(d3.data(), d_ref.data(), N));
+    assert(checkIsClose(d4.data(), d_ref.data(), N));
+
+    iterative_fft::IDFT(d2.begin(), d2.end(), d2.begin(), inverse_plan);
+    recursive_fft::ParallelIDFT(d3.begin(), d3.end(), d3.begin(), inverse_plan, FixedThreadsParallelizer());
+
+    assert(checkIsClose(d2.data(), x.data(), N));
+    assert(checkIsClose(d3.data(), x.data(), N));
+}
+
+// Checks every codelet against the O(N^2) dft, with a contiguous and a strided
+// input, and times the largest codelet against the split radix engine.
+template < class Float >
+void TestCodelets(size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    for (size_t n = 1; n <= fft_codelets::CODELET_MAX_SIZE; n *= 2) {
+        std::vector<ComplexType> x(2 * n), d_ref(n), d(n), d_strided(n);
+        for (size_t i=0; i<2 * n; i++) {
+            x[i] = ComplexType((rand() % 2*max_val) - max_val, (rand() % 2*max_val) - max_val);
+        }
+
+        std::vector<ComplexType> x_even(n);
+        for (size_t i=0; i<n; i++) {
+            x_even[i] = x[2 * i];
+        }
+
+        base_dft::DFT(x.begin(), x.begin() + n, d_ref.begin());
+        codelet_fft::DFT(x.begin(), x.begin() + n, d.begin());
+        codelet_fft::ImplDFT{}(x.begin(), x.end() - 1, d_strided.begin(), 2, false);
+
+        std::vector<ComplexType> d_even_ref(n);
+        base_dft::DFT(x_even.begin(), x_even.end(), d_even_ref.begin());
+
+        for (size_t i=0; i<n; i++) {
+            assert(std::abs(d[i] - d_ref[i]) <= 100 * std::numeric_limits<Float>::epsilon() * n * max_val);
+            assert(std::abs(d_strided[i] - d_even_ref[i]) <= 100 * std::numeric_limits<Float>::epsilon() * n * max_val);
+        }
+
+        codelet_fft::IDFT(d.begin(), d.end(), d.begin());
+        for (size_t i=0; i<n; i++) {
+            assert(std::abs(d[i] - x[i]) <= 100 * std::numeric_limits<Float>::epsilon() * n * max_val);
+        }
+    }
+
+    constexpr size_t N = fft_codelets::CODELET_MAX_SIZE;
+    std::vector<ComplexType> x(N), d_split_radix(N), d_codelet(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    // The split radix decomposition is the one engine without codelets.
+    const FftPlan<Float> plan(N, false, FftDecomposition::kSplitRadix);
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d_split_radix.begin(), plan);
+        }
+    }, title + " Split Radix - with plan");
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            fft_codelets::Codelet<N, false>::Run(x.begin(), 1, d_codelet.begin());
+        }
+    }, title + " Codelet");
+
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(d_codelet[i] - d_split_radix[i]) <= 100 * std::numeric_limits<Float>::epsilon() * N * max_val);
+    }
+}
+
+// In place iterative transforms of every decomposition, checked against the
+// out of place ones, and the unnormalized inverse. Times an in place transform
+// of size N against an out of place one.
+template < class Float >
+void TestInPlace(size_t N, size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    const std::vector<FftDecomposition> decompositions = {
+        FftDecomposition::kRadix2, FftDecomposition::kRadix4, FftDecomposition::kRadix8, FftDecomposition::kSplitRadix,
+    };
+
+    for (int logn : {0, 1, 3, 6, 7, 11}) {
+        const size_t n = size_t{1} << logn;
+        const Float tolerance = 100 * std::numeric_limits<Float>::epsilon() * (1 + logn) * n * max_val;
+
+        std::vector<ComplexType> x(n);
+        for (size_t i=0; i<n; i++) {
+            x[i] = ComplexType((rand() % 2*max_val) - max_val, (rand() % 2*max_val) - max_val);
+        }
+
+        for (FftDecomposition decomposition : decompositions) {
+            const FftPlan<Float> plan(n, false, decomposition);
+            const FftPlan<Float> inverse_plan(n, true, decomposition);
+
+            std::vector<ComplexType> d_ref(n), d(x), d_parallel(x), d_unnormalized(n);
+            iterative_fft::DFT(x.begin(), x.end(), d_ref.begin(), plan);
+            iterative_fft::DFT(d.begin(), d.end(), d.begin(), plan);
+            iterative_fft::ParallelDFT(d_parallel.begin(), d_parallel.end(), d_parallel.begin(), plan, OmpParallelizer());
+            for (size_t i=0; i<n; i++) {
+                assert(std::abs(d[i] - d_ref[i]) <= tolerance);
+                assert(std::abs(d_parallel[i] - d_ref[i]) <= tolerance);
+            }
+
+            iterative_fft::IDFT(d_ref.begin(), d_ref.end(), d_unnormalized.begin(), inverse_plan, FftNormalization::kNone);
+            iterative_fft::IDFT(d.begin(), d.end(), d.begin(), inverse_plan);
+            iterative_fft::ParallelIDFT(d_parallel.begin(), d_parallel.end(), d_parallel.begin(), inverse_plan, FixedThreadsParallelizer());
+            for (size_t i=0; i<n; i++) {
+                assert(std::abs(d[i] - x[i]) <= tolerance / n);
+                assert(std::abs(d_parallel[i] - x[i]) <= tolerance / n);
+                assert(std::abs(d_unnormalized[i] - (Float) n * x[i]) <= tolerance);
+            }
+        }
+    }
+
+    std::vector<ComplexType> x(N), d(N), d_in_place(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+    const FftPlan<Float> inverse_plan(N, true);
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::IDFT(x.begin(), x.end(), d.begin(), inverse_plan);
+        }
+    }, title + " Iterative inverse - out of place");
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            d_in_place = x;
+            iterative_fft::IDFT(d_in_place.begin(), d_in_place.end(), d_in_place.begin(), inverse_plan);
+        }
+    }, title + " Iterative inverse - in place, with a copy of the input");
+
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(d_in_place[i] - d[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+}
+
+// Transforms of a length that is not a power of 2 with Bluestein's algorithm,
+// checked against the O(N^2) dft.
+void TestBluestein(size_t N) {
+    constexpr FloatType max_val = 1000;
+
+    std::vector<Complex> x(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    std::vector<Complex> d_ref(N), d1(N), d2(N), d3(N), d4(N);
+
+    const BluesteinPlan<FloatType> forward_plan(N, false);
+    const BluesteinPlan<FloatType> inverse_plan(N, true);
+
+    auto func_ref = [&](){ base_dft::DFT(x.begin(), x.end(), d_ref.begin()); };
+    auto func1 = [&](){ bluestein_fft::DFT(x.begin(), x.end(), d1.begin()); };
+    auto func2 = [&](){ bluestein_fft::DFT(x.begin(), x.end(), d2.begin(), forward_plan); };
+    auto func3 = [&](){ bluestein_fft::ParallelDFT(x.begin(), x.end(), d3.begin(), FixedThreadsParallelizer()); };
+    auto func4 = [&](){ bluestein_fft::ParallelDFT(x.begin(), x.end(), d4.begin(), forward_plan, OmpParallelizer()); };
+
+    timeFunction(func_ref, "Base DFT");
+    timeFunction(func1, "Bluestein - without plan");
+    timeFunction(func2, "Bluestein - with plan");
+    timeFunction(func3, "Fixed Threads Bluestein - parallel");
+    timeFunction(func4, "Omp Bluestein - parallel with plan");
+
+    assert(checkIsClose(d1.data(), d_ref.data(), N));
+    assert(checkIsClose(d2.data(), d_ref.data(), N));
+    assert(checkIsClose(d3.data(), d_ref.data(), N));
+    assert(checkIsClose(d4.data(), d_ref.data(), N));
+
+    bluestein_fft::IDFT(d1.begin(), d1.end(), d1.begin());
+    bluestein_fft::IDFT(d2.begin(), d2.end(), d2.begin(), inverse_plan);
+    bluestein_fft::ParallelIDFT(d3.begin(), d3.end(), d3.begin(), inverse_plan, FixedThreadsParallelizer());
+
+    assert(checkIsClose(d1.data(), x.data(), N));
+    assert(checkIsClose(d2.data(), x.data(), N));
+    assert(checkIsClose(d3.data(), x.data(), N));
+}
+
+// Mixed radix transforms of sizes with prime factors 2, 3, 5 and 7, checked
+// against the O(N^2) dft and timed against Bluestein and the power of 2
+// transform of size P2.
+void TestMixedRadix(size_t N, size_t P2, size_t repetitions) {
+    constexpr FloatType max_val = 1000;
+
+    std::vector<Complex> x(N), x_pow2(P2);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+    for (size_t i=0; i<P2; i++) {
+        x_pow2[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    std::vector<Complex> d_ref(N), d1(N), d2(N), d3(N), d4(N), d_pow2(P2);
+    base_dft::DFT(x.begin(), x.end(), d_ref.begin());
+
+    const MixedRadixPlan<FloatType> forward_plan(N, false);
+    const MixedRadixPlan<FloatType> inverse_plan(N, true);
+    const BluesteinPlan<FloatType> bluestein_plan(N, false);
+    const FftPlan<FloatType> pow2_plan(P2, false);
+
+    auto func1 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            mixed_radix_fft::DFT(x.begin(), x.end(), d1.begin(), forward_plan);
+        }
+    };
+    auto func2 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            mixed_radix_fft::ParallelDFT(x.begin(), x.end(), d2.begin(), forward_plan, OmpParallelizer());
+        }
+    };
+    auto func3 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            bluestein_fft::DFT(x.begin(), x.end(), d3.begin(), bluestein_plan);
+        }
+    };
+    auto func4 = [&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x_pow2.begin(), x_pow2.end(), d_pow2.begin(), pow2_plan);
+        }
+    };
+
+    timeFunction(func1, "Mixed Radix - with plan");
+    timeFunction(func2, "Omp Mixed Radix - with plan");
+    timeFunction(func3, "Bluestein - with plan");
+    timeFunction(func4, "Iterative - power of 2 size " + std::to_string(P2));
+
+    mixed_radix_fft::ParallelDFT(x.begin(), x.end(), d4.begin(), FixedThreadsParallelizer());
+
+    assert(checkIsClose(d1.data(), d_ref.data(), N));
+    assert(checkIsClose(d2.data(), d_ref.data(), N));
+    assert(checkIsClose(d3.data(), d_ref.data(), N));
+    assert(checkIsClose(d4.data(), d_ref.data(), N));
+
+    mixed_radix_fft::IDFT(d1.begin(), d1.end(), d1.begin(), inverse_plan);
+    mixed_radix_fft::ParallelIDFT(d2.begin(), d2.end(), d2.begin(), FixedThreadsParallelizer());
+
+    assert(checkIsClose(d1.data(), x.data(), N));
+    assert(checkIsClose(d2.data(), x.data(), N));
+}
+
+// Times forward transforms in precision Float, reports the throughput with
+// the usual 5 N log2(N) flop count and the relative RMS error against long
+// double.
+template < class Float >
+void MeasurePrecision(size_t N, size_t repetitions, std::string title) {
+    constexpr FloatType max_val = 1000;
+
+    std::vector<Complex> x_ref(N), d_ref(N);
+    for (size_t i=0; i<N; i++) {
+        x_ref[i] = (rand() % 2*max_val) - max_val;
+    }
+    iterative_fft::DFT(x_ref.begin(), x_ref.end(), d_ref.begin());
+
+    std::vector<ComplexOf<Float>> x(x_ref.begin(), x_ref.end()), d(N);
+    const FftPlan<Float> plan(N, false);
+
+    const double seconds = measureSeconds([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d.begin(), plan);
+        }
+    });
+
+    // Relative root mean square error
+    FloatType error_norm = 0, ref_norm = 0;
+    for (size_t i=0; i<N; i++) {
+        error_norm += std::norm((Complex) d[i] - d_ref[i]);
+        ref_norm += std::norm(d_ref[i]);
+    }
+    const FloatType relative_error = std::sqrt(error_norm / ref_norm);
+
+    const double flops = 5.0 * N * fft_utils::IntLog2(N) * repetitions;
+    std::cout << "Precision " << title << ": " << (int) (flops / seconds * 1e-6) << " MFlop/s, "
+              << "relative error " << (double) relative_error << std::endl;
+    assert(relative_error < 10 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N));
+}
+
+// Runs the iterative FFT with every instruction set supported by the CPU and
+// checks that they agree with the scalar kernels.
+template < class Float >
+void CompareSimdKernels(size_t N, size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    std::vector<ComplexType> x(N), d_scalar(N), d_simd(N), d_parallel(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    const FftPlan<Float> plan(N, false);
+    const simd::InstructionSet detected = simd::DetectInstructionSet();
+
+    simd::SetInstructionSet(simd::InstructionSet::kScalar);
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d_scalar.begin(), plan);
+        }
+    }, title + " Scalar");
+
+    for (auto instruction_set : {simd::InstructionSet::kAvx2, simd::InstructionSet::kAvx512}) {
+        if (static_cast<int>(instruction_set) > static_cast<int>(detected)) {
+            continue;
+        }
+        simd::SetInstructionSet(instruction_set);
+        const std::string name = simd::InstructionSetName(instruction_set);
+
+        timeFunction([&](){
+            for (size_t r = 0; r < repetitions; r++) {
+                iterative_fft::DFT(x.begin(), x.end(), d_simd.begin(), plan);
+            }
+        }, title + " " + name);
+
+        timeFunction([&](){
+            for (size_t r = 0; r < repetitions; r++) {
+                iterative_fft::ParallelDFT(x.begin(), x.end(), d_parallel.begin(), plan, OmpParallelizer());
+            }
+        }, title + " Omp " + name);
+
+        // Differences come from the fused multiply-adds only
+        Float max_diff = 0, max_value = 0;
+        for (size_t i=0; i<N; i++) {
+            max_diff = std::max(max_diff, std::abs(d_simd[i] - d_scalar[i]));
+            max_diff = std::max(max_diff, std::abs(d_parallel[i] - d_scalar[i]));
+            max_value = std::max(max_value, std::abs(d_scalar[i]));
+        }
+        assert(max_diff <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+    }
+
+    simd::SetInstructionSet(detected);
+}
+
+// Times the stage decompositions of the iterative engine against radix 2.
+template < class Float >
+void CompareDecompositions(size_t N, size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    std::vector<ComplexType> x(N), d_radix2(N), d(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    const std::vector<std::pair<FftDecomposition, std::string>> decompositions = {
+        {FftDecomposition::kRadix2, "Radix 2"},
+        {FftDecomposition::kRadix4, "Radix 4"},
+        {FftDecomposition::kRadix8, "Radix 8"},
+        {FftDecomposition::kSplitRadix, "Split Radix"},
+    };
+
+    for (const auto &[decomposition, name] : decompositions) {
+        const FftPlan<Float> plan(N, false, decomposition);
+        auto &out = (decomposition == FftDecomposition::kRadix2) ? d_radix2 : d;
+
+        timeFunction([&](){
+            for (size_t r = 0; r < repetitions; r++) {
+                iterative_fft::DFT(x.begin(), x.end(), out.begin(), plan);
+            }
+        }, title + " " + name);
+
+        Float max_diff = 0, max_value = 0;
+        for (size_t i=0; i<N; i++) {
+            max_diff = std::max(max_diff, std::abs(out[i] - d_radix2[i]));
+            max_value = std::max(max_value, std::abs(d_radix2[i]));
+        }
+        assert(max_diff <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+
+        iterative_fft::ParallelDFT(x.begin(), x.end(), out.begin(), plan, FixedThreadsParallelizer());
+        for (size_t i=0; i<N; i++) {
+            max_diff = std::max(max_diff, std::abs(out[i] - d_radix2[i]));
+        }
+        assert(max_diff <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+    }
+}
+
+// The parallel iterative engine with more threads than the last passes have
+// blocks, so that their columns are split between the threads, against the
+// sequential engine. Times both engines on a transform of size N.
+template < class Float >
+void CompareParallelStages(size_t N, size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    for (int logn = 7; logn <= 13; logn += 3) {
+        const size_t n = size_t{1} << logn;
+        const Float tolerance = 100 * std::numeric_limits<Float>::epsilon() * logn * n * max_val;
+
+        std::vector<ComplexType> x(n), d_ref(n), d(n);
+        for (size_t i=0; i<n; i++) {
+            x[i] = ComplexType((rand() % 2*max_val) - max_val, (rand() % 2*max_val) - max_val);
+        }
+
+        for (FftDecomposition decomposition : {FftDecomposition::kRadix2, FftDecomposition::kRadix4, FftDecomposition::kRadix8}) {
+            const FftPlan<Float> plan(n, false, decomposition);
+            iterative_fft::DFT(x.begin(), x.end(), d_ref.begin(), plan);
+
+            for (size_t num_threads : {2, 3, 8}) {
+                iterative_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, FixedThreadsParallelizer(num_threads));
+                for (size_t i=0; i<n; i++) {
+                    assert(std::abs(d[i] - d_ref[i]) <= tolerance);
+                }
+
+                d = x;
+                iterative_fft::ParallelDFT(d.begin(), d.end(), d.begin(), plan, FixedThreadsParallelizer(num_threads));
+                for (size_t i=0; i<n; i++) {
+                    assert(std::abs(d[i] - d_ref[i]) <= tolerance);
+                }
+
+                d = x;
+                iterative_fft::ParallelDFT(d.begin(), d.end(), d.begin(), plan, ThreadPoolParallelizer(num_threads));
+                for (size_t i=0; i<n; i++) {
+                    assert(std::abs(d[i] - d_ref[i]) <= tolerance);
+                }
+            }
+        }
+    }
+
+    // The radix 2 stage split in column ranges that are not multiples of the
+    // register width against the whole stage, on every instruction set.
+    const simd::InstructionSet detected = simd::DetectInstructionSet();
+    for (auto instruction_set : {simd::InstructionSet::kScalar, simd::InstructionSet::kAvx2, simd::InstructionSet::kAvx512}) {
+        if (static_cast<int>(instruction_set) > static_cast<int>(detected)) {
+            continue;
+        }
+        simd::SetInstructionSet(instruction_set);
+
+        for (int logn = 1; logn <= 10; logn++) {
+            const size_t n = size_t{1} << logn;
+            const size_t half = n / 2;
+            const FftPlan<Float> plan(n, false);
+            const std::complex<Float> *twiddles = plan.StageTwiddles(logn);
+
+            std::vector<ComplexType> d_ref(n), d(n);
+            for (size_t i=0; i<n; i++) {
+                d_ref[i] = ComplexType((rand() % 2*max_val) - max_val, (rand() % 2*max_val) - max_val);
+            }
+            d = d_ref;
+
+            dft_detail::RadixTwoStage(d_ref.begin(), n, half, twiddles);
+
+            const size_t first_split = half / 3;
+            const size_t second_split = std::min(half, 2 * half / 3 + 1);
+            dft_detail::RadixTwoColumns(d.begin(), half, 0, first_split, twiddles);
+            dft_detail::RadixTwoColumns(d.begin(), half, first_split, second_split, twiddles);
+            dft_detail::RadixTwoColumns(d.begin(), half, second_split, half, twiddles);
+
+            for (size_t i=0; i<n; i++) {
+                assert(std::abs(d[i] - d_ref[i]) <= 100 * std::numeric_limits<Float>::epsilon() * max_val);
+            }
+        }
+    }
+    simd::SetInstructionSet(detected);
+
+    std::vector<ComplexType> x(N), d(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+    const FftPlan<Float> plan(N, false);
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d.begin(), plan);
+        }
+    }, title + " Iterative - sequential");
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, FixedThreadsParallelizer());
+        }
+    }, title + " Fixed Threads Iterative - parallel");
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, OmpParallelizer());
+        }
+    }, title + " Omp Iterative - parallel");
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, ThreadPoolParallelizer::Shared());
+        }
+    }, title + " Thread Pool Iterative - parallel");
+}
+
+// Times the Stockham auto-sort engine against the iterative engine, which
+// starts with a bit reversal pass.
+template < class Float >
+void CompareStockham(size_t N, size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    std::vector<ComplexType> x(N), d_iterative(N), d_stockham(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    const FftPlan<Float> plan(N, false);
+    const FftPlan<Float> inverse_plan(N, true);
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            iterative_fft::DFT(x.begin(), x.end(), d_iterative.begin(), plan);
+        }
+    }, title + " Iterative");
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            stockham_fft::DFT(x.begin(), x.end(), d_stockham.begin(), plan);
+        }
+    }, title + " Stockham");
+
+    Float max_diff = 0, max_value = 0;
+    for (size_t i=0; i<N; i++) {
+        max_diff = std::max(max_diff, std::abs(d_stockham[i] - d_iterative[i]));
+        max_value = std::max(max_value, std::abs(d_iterative[i]));
+    }
+    assert(max_diff <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+
+    stockham_fft::IDFT(d_stockham.begin(), d_stockham.end(), d_stockham.begin(), inverse_plan);
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(d_stockham[i] - x[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+}
+
+// Times the four step engine against the iterative engine on transforms that
+// do not fit in cache.
+template < class Float >
+void CompareFourStep(size_t N, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    std::vector<ComplexType> x(N), d_iterative(N), d(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    const FftPlan<Float> plan(N, false);
+    const FourStepPlan<Float> four_step_plan(N, false);
+
+    timeFunction([&](){ iterative_fft::DFT(x.begin(), x.end(), d_iterative.begin(), plan); }, title + " Iterative - sequential");
+
+    const auto check = [&]() {
+        Float max_diff = 0, max_value = 0;
+        for (size_t i=0; i<N; i++) {
+            max_diff = std::max(max_diff, std::abs(d[i] - d_iterative[i]));
+            max_value = std::max(max_value, std::abs(d_iterative[i]));
+        }
+        assert(max_diff <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+    };
+
+    timeFunction([&](){ four_step_fft::DFT(x.begin(), x.end(), d.begin(), four_step_plan); }, title + " Four Step - sequential");
+    check();
+
+    timeFunction([&](){ iterative_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, FixedThreadsParallelizer()); }, title + " Fixed Threads Iterative - parallel");
+    check();
+
+    timeFunction([&](){ four_step_fft::ParallelDFT(x.begin(), x.end(), d.begin(), four_step_plan, FixedThreadsParallelizer()); }, title + " Fixed Threads Four Step - parallel");
+    check();
+
+    timeFunction([&](){ four_step_fft::ParallelDFT(x.begin(), x.end(), d.begin(), four_step_plan, OmpParallelizer()); }, title + " Omp Four Step - parallel");
+    check();
+
+    four_step_fft::IDFT(d.begin(), d.end(), d.begin());
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(d[i] - x[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+}
+
+// Checks the cache blocked bit reversal permutation against the definition,
+// in place, out of place and in parallel, and times it against the element
+// by element permutation.
+void TestBitReversal(int logN) {
+    const size_t N = size_t{1} << logN;
+
+    std::vector<Complex> x(N), expected(N), d(N), d_in_place(N), d_parallel(N);
+    for (size_t i=0; i<N; i++) {
+        x[i] = Complex(i, -(FloatType) i);
+    }
+
+    timeFunction([&](){
+        for (size_t i=0; i<N; i++) {
+            size_t j = 0;
+            for (int bit=0; bit<logN; bit++) {
+                j |= ((i >> bit) & 1) << (logN - 1 - bit);
+            }
+            expected[j] = x[i];
+        }
+    }, "Element by element");
+
+    timeFunction([&](){ fft_utils::BitReversalPermutation(x.begin(), x.end(), d.begin()); }, "Cache blocked");
+
+    d_in_place = x;
+    timeFunction([&](){ fft_utils::BitReversalPermutation(d_in_place.begin(), d_in_place.end(), d_in_place.begin()); }, "Cache blocked - in place");
+
+    timeFunction([&](){ fft_utils::ParallelBitReversalPermutation(x.begin(), x.end(), d_parallel.begin(), FixedThreadsParallelizer()); }, "Fixed Threads Cache blocked - parallel");
+
+    assert(d == expected);
+    assert(d_in_place == expected);
+    assert(d_parallel == expected);
+
+    fft_utils::ParallelBitReversalPermutation(d_parallel.begin(), d_parallel.end(), d_parallel.begin(), OmpParallelizer());
+    assert(d_parallel == x);
+}
+
+// Times a batch of transforms sharing one plan against a loop of single
+// transforms, and checks the contiguous, strided, in place and parallel
+// batches against the loop.
+template < class Float >
+void CompareBatched(size_t N, size_t batch_size, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    std::vector<ComplexType> x(N * batch_size), d_loop(N * batch_size), d(N * batch_size);
+    for (size_t i=0; i<N * batch_size; i++) {
+        x[i] = (rand() % 2*max_val) - max_val;
+    }
+
+    const FftPlan<Float> plan(N, false);
+    const FftPlan<Float> inverse_plan(N, true);
+
+    timeFunction([&](){
+        for (size_t b = 0; b < batch_size; b++) {
+            iterative_fft::DFT(x.begin() + b * N, x.begin() + (b + 1) * N, d_loop.begin() + b * N, plan);
+        }
+    }, title + " Loop of single transforms");
+
+    Float max_value = 0;
+    for (size_t i=0; i<N * batch_size; i++) {
+        max_value = std::max(max_value, std::abs(d_loop[i]));
+    }
+    const auto check = [&]() {
+        for (size_t i=0; i<N * batch_size; i++) {
+            assert(std::abs(d[i] - d_loop[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+        }
+    };
+
+    timeFunction([&](){ batched_fft::DFT(x.begin(), x.end(), d.begin(), plan); }, title + " Batched - sequential");
+    check();
+
+    timeFunction([&](){ batched_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, FixedThreadsParallelizer()); }, title + " Fixed Threads Batched - parallel");
+    check();
+
+    timeFunction([&](){ batched_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, OmpParallelizer()); }, title + " Omp Batched - parallel");
+    check();
+
+    // Signal b stored as column b of an N x batch_size matrix.
+    std::vector<ComplexType> columns(N * batch_size);
+    for (size_t b = 0; b < batch_size; b++) {
+        for (size_t i=0; i<N; i++) {
+            columns[i * batch_size + b] = x[b * N + i];
+        }
+    }
+    const BatchLayout strided{batch_size, batch_size, 1, N};
+    batched_fft::DFT(strided, columns.begin(), d.begin(), plan);
+    check();
+    batched_fft::ParallelDFT(strided, columns.begin(), d.begin(), plan, FixedThreadsParallelizer());
+    check();
+
+    // A batch too small to be split across the threads.
+    const BatchLayout small = BatchLayout::Contiguous(3, N);
+    std::fill(d.begin(), d.end(), ComplexType(0));
+    batched_fft::ParallelDFT(small, x.begin(), d.begin(), plan, OmpParallelizer());
+    for (size_t i=0; i<3 * N; i++) {
+        assert(std::abs(d[i] - d_loop[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value);
+    }
+
+    d = d_loop;
+    batched_fft::IDFT(d.begin(), d.end(), d.begin(), inverse_plan);
+    for (size_t i=0; i<N * batch_size; i++) {
+        assert(std::abs(d[i] - x[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+
+    d = d_loop;
+    batched_fft::ParallelIDFT(small, d.begin(), d.begin(), inverse_plan, FixedThreadsParallelizer());
+    batched_fft::ParallelIDFT(BatchLayout::Contiguous(batch_size - 3, N), d.begin() + 3 * N, d.begin() + 3 * N, inverse_plan, FixedThreadsParallelizer());
+    for (size_t i=0; i<N * batch_size; i++) {
+        assert(std::abs(d[i] - x[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+}
+
+// Times the multidimensional transforms against a loop of 1D transforms
+// along every axis, gathering the lines of the other axes by hand, and checks
+// the complex and real input transforms, sequential and parallel, against it.
+template < class Float >
+void CompareMultiDim(const std::vector<size_t> &shape, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    const MultiDimPlan<Float> plan(shape, false);
+    const MultiDimPlan<Float> inverse_plan(shape, true);
+    const MultiDimPlan<Float> real_plan(shape, false, true);
+    const MultiDimPlan<Float> real_inverse_plan(shape, true, true);
+    const size_t N = plan.Size();
+
+    std::vector<Float> x_real(N);
+    std::vector<ComplexType> x(N), d_loop(N), d(N);
+    for (size_t i=0; i<N; i++) {
+        x_real[i] = (rand() % 2*max_val) - max_val;
+        x[i] = x_real[i];
+    }
+
+    timeFunction([&](){
+        d_loop = x;
+        size_t inner = 1;
+        for (int axis = plan.Rank() - 1; axis >= 0; axis--) {
+            const size_t length = shape[axis];
+            std::vector<ComplexType> line(length), line_out(length);
+            for (size_t o = 0; o < N / (length * inner); o++) {
+                for (size_t j = 0; j < inner; j++) {
+                    const size_t start = o * length * inner + j;
+                    for (size_t k = 0; k < length; k++) {
+                        line[k] = d_loop[start + k * inner];
+                    }
+                    iterative_fft::DFT(line.begin(), line.end(), line_out.begin(), plan.AxisPlan(axis));
+                    for (size_t k = 0; k < length; k++) {
+                        d_loop[start + k * inner] = line_out[k];
+                    }
+                }
+            }
+            inner *= length;
+        }
+    }, title + " Loop of 1D transforms");
+
+    Float max_value = 0;
+    for (size_t i=0; i<N; i++) {
+        max_value = std::max(max_value, std::abs(d_loop[i]));
+    }
+    const Float tolerance = 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_value;
+    const auto check = [&]() {
+        for (size_t i=0; i<N; i++) {
+            assert(std::abs(d[i] - d_loop[i]) <= tolerance);
+        }
+    };
+
+    timeFunction([&](){ multidim_fft::DFT(x.begin(), x.end(), d.begin(), plan); }, title + " MultiDim - sequential");
+    check();
+
+    timeFunction([&](){ multidim_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, FixedThreadsParallelizer()); }, title + " Fixed Threads MultiDim - parallel");
+    check();
+
+    timeFunction([&](){ multidim_fft::ParallelDFT(x.begin(), x.end(), d.begin(), plan, OmpParallelizer()); }, title + " Omp MultiDim - parallel");
+    check();
+
+    multidim_fft::IDFT(d.begin(), d.end(), d.begin(), inverse_plan);
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(d[i] - x[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+
+    // The half spectrum holds the first n / 2 + 1 values of every row of the
+    // complex spectrum.
+    const size_t n = shape.back();
+    const size_t h = n / 2 + 1;
+    std::vector<ComplexType> spectrum(real_plan.SpectrumSize());
+    const auto check_half = [&]() {
+        for (size_t r = 0; r < N / n; r++) {
+            for (size_t k = 0; k < h; k++) {
+                assert(std::abs(spectrum[r * h + k] - d_loop[r * n + k]) <= tolerance);
+            }
+        }
+    };
+
+    timeFunction([&](){ multidim_fft::RealDFT(x_real.begin(), x_real.end(), spectrum.begin(), real_plan); }, title + " Real MultiDim - sequential");
+    check_half();
+
+    timeFunction([&](){ multidim_fft::ParallelRealDFT(x_real.begin(), x_real.end(), spectrum.begin(), real_plan, FixedThreadsParallelizer()); }, title + " Fixed Threads Real MultiDim - parallel");
+    check_half();
+
+    std::vector<Float> y(N), y_parallel(N);
+    multidim_fft::RealIDFT(spectrum.begin(), spectrum.end(), y.begin(), real_inverse_plan);
+    multidim_fft::ParallelRealIDFT(spectrum.begin(), spectrum.end(), y_parallel.begin(), real_inverse_plan, OmpParallelizer());
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(y[i] - x_real[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+        assert(std::abs(y_parallel[i] - x_real[i]) <= 100 * std::numeric_limits<Float>::epsilon() * fft_utils::IntLog2(N) * max_val);
+    }
+}
+
+// Transforms of real signals of length N, even or odd, checked against the
+// complex transform and timed against it.
+template < class Float >
+void CompareRealFft(size_t N, size_t repetitions, std::string title) {
+    using ComplexType = ComplexOf<Float>;
+    constexpr Float max_val = 1000;
+
+    const RealFftPlan<Float> plan(N, false);
+    const RealFftPlan<Float> inverse_plan(N, true);
+    const bool is_mixed_radix = fft_utils::IsSmooth(N) && !fft_utils::IsPowerOfTwo(N);
+    const BluesteinPlan<Float> bluestein_plan(is_mixed_radix ? 1 : N, false);
+    const MixedRadixPlan<Float> mixed_radix_plan(is_mixed_radix ? N : 1, false);
+    const size_t h = plan.SpectrumSize();
+
+    std::vector<Float> x_real(N);
+    std::vector<ComplexType> x(N), d_ref(N);
+    for (size_t i=0; i<N; i++) {
+        x_real[i] = (rand() % 2*max_val) - max_val;
+        x[i] = x_real[i];
+    }
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            if (is_mixed_radix) {
+                mixed_radix_fft::DFT(x.begin(), x.end(), d_ref.begin(), mixed_radix_plan);
+            } else {
+                bluestein_fft::DFT(x.begin(), x.end(), d_ref.begin(), bluestein_plan);
+            }
+        }
+    }, title + " Complex transform - with plan");
+
+    Float max_value = 0;
+    for (size_t i=0; i<N; i++) {
+        max_value = std::max(max_value, std::abs(d_ref[i]));
+    }
+    const Float tolerance = 100 * std::numeric_limits<Float>::epsilon() * (1 + fft_utils::IntLog2(N)) * max_value;
+    std::vector<ComplexType> spectrum(h), spectrum_parallel(h);
+    const auto check = [&](const std::vector<ComplexType> &d) {
+        for (size_t k=0; k<h; k++) {
+            assert(std::abs(d[k] - d_ref[k]) <= tolerance);
+        }
+    };
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            real_fft::RFFT(x_real.begin(), x_real.end(), spectrum.begin(), plan);
+        }
+    }, title + " RFFT - with plan");
+    check(spectrum);
+
+    timeFunction([&](){
+        for (size_t r = 0; r < repetitions; r++) {
+            real_fft::ParallelRFFT(x_real.begin(), x_real.end(), spectrum_parallel.begin(), plan, OmpParallelizer());
+        }
+    }, title + " Omp RFFT - parallel with plan");
+    check(spectrum_parallel);
+
+    real_fft::RFFT(x_real.begin(), x_real.end(), spectrum.begin());
+    check(spectrum);
+    real_fft::ParallelRFFT(x_real.begin(), x_real.end(), spectrum_parallel.begin(), FixedThreadsParallelizer());
+    check(spectrum_parallel);
+
+    std::vector<Float> y(N), y_parallel(N);
+    real_fft::IRFFT(spectrum.begin(), spectrum.end(), y.begin(), inverse_plan);
+    real_fft::ParallelIRFFT(spectrum.begin(), spectrum.end(), y_parallel.begin(), inverse_plan, FixedThreadsParallelizer());
+    const Float inverse_tolerance = 100 * std::numeric_limits<Float>::epsilon() * (1 + fft_utils::IntLog2(N)) * max_val;
+    for (size_t i=0; i<N; i++) {
+        assert(std::abs(y[i] - x_real[i]) <= inverse_tolerance);
+        assert(std::abs(y_parallel[i] - x_real[i]) <= inverse_tolerance);
+    }
+
+    if (N % 2 == 0) {
+        real_fft::IRFFT(spectrum.begin(), spectrum.end(), y.begin());
+        real_fft::ParallelIRFFT(spectrum.begin(), spectrum.end(), y_parallel.begin(), OmpParallelizer());
+        for (size_t i=0; i<N; i++) {
+            assert(std::abs(y[i] - x_real[i]) <= inverse_tolerance);
+            assert(std::abs(y_parallel[i] - x_real[i]) <= inverse_tolerance);
+        }
+    }
 }
 
 int main()
@@ -187,6 +1098,114 @@ int main()
     TestParallelDFT(1 << 12);
     std::cout << line << std::endl;
 
+    for (int logN : {0, 3, 8, 13, 20}) {
+        std::cout << ">>> Bit reversal, Input Size 2^" << logN << "\n";
+        TestBitReversal(logN);
+        std::cout << line << std::endl;
+    }
+
+    std::cout << ">>> Plan reuse, Input Size 2^10, 1000 transforms\n";
+    TestFftPlan(1 << 10, 1000);
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Codelets, Input Sizes 1 to 64, 100000 transforms of size 64\n";
+    TestCodelets<float>(100000, "float");
+    TestCodelets<double>(100000, "double");
+    TestCodelets<long double>(100000, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> In place, Input Size 2^20, 5 transforms\n";
+    TestInPlace<float>(1 << 20, 5, "float");
+    TestInPlace<double>(1 << 20, 5, "double");
+    TestInPlace<long double>(1 << 20, 5, "long double");
+    std::cout << line << std::endl;
+
+    for (size_t N : {1, 7, 3000, 6000, 10000}) {
+        std::cout << ">>> Bluestein, Input Size " << N << "\n";
+        TestBluestein(N);
+        std::cout << line << std::endl;
+    }
+
+    std::cout << ">>> Mixed Radix, Input Size 1000, 100 transforms\n";
+    TestMixedRadix(1000, 1 << 10, 100);
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Mixed Radix, Input Size 4800, 100 transforms\n";
+    TestMixedRadix(4800, 1 << 12, 100);
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Precision, Input Size 2^16, 50 transforms\n";
+    MeasurePrecision<float>(1 << 16, 50, "float");
+    MeasurePrecision<double>(1 << 16, 50, "double");
+    MeasurePrecision<long double>(1 << 16, 50, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> SIMD kernels, Input Size 2^18, 20 transforms\n";
+    CompareSimdKernels<float>(1 << 18, 20, "float");
+    CompareSimdKernels<double>(1 << 18, 20, "double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Stage decompositions, Input Size 2^20, 5 transforms\n";
+    CompareDecompositions<double>(1 << 20, 5, "double");
+    CompareDecompositions<long double>(1 << 20, 5, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Parallel stages, Input Size 2^20, 5 transforms\n";
+    CompareParallelStages<float>(1 << 20, 5, "float");
+    CompareParallelStages<double>(1 << 20, 5, "double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Stockham, Input Size 2^12, 1000 transforms\n";
+    CompareStockham<double>(1 << 12, 1000, "double");
+    CompareStockham<long double>(1 << 12, 1000, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Stockham, Input Size 2^20, 5 transforms\n";
+    CompareStockham<double>(1 << 20, 5, "double");
+    CompareStockham<long double>(1 << 20, 5, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Four Step, Input Size 2^22\n";
+    CompareFourStep<double>(1 << 22, "double");
+    CompareFourStep<long double>(1 << 22, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> Four Step, Input Size 2^24\n";
+    CompareFourStep<double>(1 << 24, "double");
+    std::cout << line << std::endl;
+
+    for (size_t N : {1 << 6, 1 << 10, 1 << 16}) {
+        std::cout << ">>> Batched, Input Size " << N << ", " << (1 << 20) / N << " transforms\n";
+        CompareBatched<float>(N, (1 << 20) / N, "float");
+        CompareBatched<double>(N, (1 << 20) / N, "double");
+        CompareBatched<long double>(N, (1 << 20) / N, "long double");
+        std::cout << line << std::endl;
+    }
+
+    std::cout << ">>> MultiDim, Shape 1024 x 1024\n";
+    CompareMultiDim<double>({1024, 1024}, "double");
+    CompareMultiDim<float>({1024, 1024}, "float");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> MultiDim, Shape 64 x 128 x 32\n";
+    CompareMultiDim<double>({64, 128, 32}, "double");
+    CompareMultiDim<long double>({64, 128, 32}, "long double");
+    std::cout << line << std::endl;
+
+    std::cout << ">>> MultiDim, Shapes 1 x 8, 8 x 1, 2 x 1 x 2\n";
+    CompareMultiDim<double>({1, 8}, "double");
+    CompareMultiDim<double>({8, 1}, "double");
+    CompareMultiDim<double>({2, 1, 2}, "double");
+    std::cout << line << std::endl;
+
+    for (size_t N : {1, 2, 7, 30, 1000, 6002, 1 << 16}) {
+        std::cout << ">>> Real FFT, Input Size " << N << ", 20 transforms\n";
+        CompareRealFft<float>(N, 20, "float");
+        CompareRealFft<double>(N, 20, "double");
+        CompareRealFft<long double>(N, 20, "long double");
+        std::cout << line << std::endl;
+    }
+
     std::cout << ">>> Input Size 2^18\n";
     CompareParallelDFT(1 << 18);
     std::cout << line << std::endl;
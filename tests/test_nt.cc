@@ -3,6 +3,11 @@
 #include <number_theory/number_theory.h>
 #include <core/modular_fft.h>
 
+#include <tests/benchmark_timer.h>
+
+#include <random>
+#include <thread>
+
 template <typename T>
 void PrintVec(std::vector<T> vec) {
     for (auto x : vec) std::cout << x << " ";
@@ -12,11 +17,15 @@ void PrintVec(std::vector<T> vec) {
 void TestChineseRemainderTheorem();
 void TestModularInverse();
 void TestModularFFT();
+void TestMontgomeryModularFFT();
+void TestNttPlanCache();
 
 int main() {
     TestChineseRemainderTheorem();
     TestModularInverse();
     TestModularFFT();
+    TestMontgomeryModularFFT();
+    TestNttPlanCache();
 }
 
 void TestModularFFT() {
@@ -42,6 +51,14 @@ void TestModularFFT() {
     printf("\nDFT:\n");
     PrintVec(out);
 
+    // The same transform as a task, chained with the inverse transform
+    std::vector<nt::Integer> async_out(N);
+    AsyncModularFftTransform(integers.begin(), integers.end(), async_out.begin(), p, g).get();
+    assert(async_out == out);
+
+    AsyncModularFftInverseTransform(async_out.begin(), async_out.end(), async_out.begin(), p, g).wait();
+    assert(async_out == integers);
+
     ModularFftInverseTransform(out.begin(), out.end(), out.begin(), p, g);
 
     printf("\nIDFT:\n");
@@ -111,4 +128,113 @@ void TestModularInverse() {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+// The Montgomery arithmetic of the transforms against 128-bit divisions, and
+// the transform with a 62-bit prime against the definition of the DFT.
+void TestMontgomeryModularFFT() {
+    using u128 = unsigned __int128;
+
+    // 29 * 2^57 + 1, with primitive root 3
+    const nt::Integer large_p = 4179340454199820289LL;
+    const nt::Integer large_g = 3;
+
+    std::mt19937_64 generator(305);
+    for (const nt::Integer p : {nt::FindPrimeInAP(1 << 20), large_p}) {
+        const modular_fft_detail::MontgomeryModulus mod(p);
+        for (int i = 0; i < 1000; i++) {
+            const uint64_t a = generator() % p;
+            const uint64_t b = generator() % p;
+            assert(mod.mul_mod(a, b) == (uint64_t) ((u128) a * b % p));
+            assert(mod.from_montgomery(mod.to_montgomery(a)) == a);
+            assert(mod.add(a, b) == (uint64_t) (((u128) a + b) % p));
+            assert(mod.sub(a, b) == (uint64_t) (((u128) a + p - b) % p));
+        }
+        assert(mod.pow(3, p - 1) == 1);
+    }
+
+    const int N = 1 << 6;
+    const modular_fft_detail::MontgomeryModulus mod(large_p);
+    const uint64_t omega = mod.pow(large_g, (large_p - 1) / N);
+
+    std::vector<nt::Integer> integers(N), out(N);
+    for (int i = 0; i < N; i++) {
+        integers[i] = (nt::Integer) (generator() % large_p) - large_p / 2;
+    }
+
+    ModularFftTransform(integers.begin(), integers.end(), out.begin(), large_p, large_g);
+
+    for (int j = 0; j < N; j++) {
+        uint64_t expected = 0;
+        for (int i = 0; i < N; i++) {
+            const uint64_t x = nt::SafeMod(integers[i], large_p);
+            expected = mod.add(expected, mod.mul_mod(x, mod.pow(omega, (uint64_t) i * j)));
+        }
+        assert((uint64_t) out[j] == expected);
+    }
+
+    ModularFftInverseTransform(out.begin(), out.end(), out.begin(), large_p, large_g);
+    for (int i = 0; i < N; i++) {
+        assert(out[i] == nt::SafeMod(integers[i], large_p));
+    }
+
+    // A transform of 2^20 points
+    const nt::Integer size = 1 << 20;
+    const nt::Integer p = nt::FindPrimeInAP(size);
+    const nt::Integer g = nt::PrimitiveRootModPrime(p);
+
+    std::vector<nt::Integer> values(size);
+    for (auto &value : values) {
+        value = generator() % p;
+    }
+    timeFunction([&](){ ModularFftTransform(values.begin(), values.end(), values.begin(), p, g); }, "Modular FFT 2^20");
+}
+
+// Plans are built once per (p, N), also by concurrent callers, and give the
+// same transforms as the explicit root.
+void TestNttPlanCache() {
+    const size_t N = 1 << 16;
+    const nt::Integer p = nt::FindPrimeInAP(N);
+
+    std::shared_ptr<const NttPlan> first_plan;
+    timeFunction([&](){ first_plan = NttPlan::Cached(p, N); }, "Ntt plan - first call");
+
+    std::shared_ptr<const NttPlan> second_plan;
+    timeFunction([&](){ second_plan = NttPlan::Cached(p, N); }, "Ntt plan - cached");
+    assert(first_plan == second_plan);
+    assert(NttPlan::Cached(p, N / 2) != first_plan);
+    assert(NttPlan::Cached(p, N, first_plan->Root()) == first_plan);
+
+    // Any other primitive root, such as the inverse of g, has its own plan
+    const nt::Integer other_root = nt::MultiplicativeInverse(first_plan->Root(), p);
+    const auto other_plan = NttPlan::Cached(p, N, other_root);
+    assert(other_plan != first_plan && other_plan->Root() == other_root);
+    assert(NttPlan::Cached(p, N, other_root) == other_plan);
+
+    // Concurrent callers of a new key all get the same plan
+    const nt::Integer q = nt::FindPrimesInAP(N, 2)[1];
+    std::vector<std::shared_ptr<const NttPlan>> plans(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < plans.size(); t++) {
+        threads.emplace_back([&plans, q, N, t](){ plans[t] = NttPlan::Cached(q, N); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (const auto &plan : plans) {
+        assert(plan == plans[0]);
+    }
+
+    std::mt19937_64 generator(305);
+    std::vector<nt::Integer> values(N), with_plan(N), with_root(N);
+    for (auto &value : values) {
+        value = generator() % p;
+    }
+
+    ModularFftTransform(values.begin(), values.end(), with_plan.begin(), *first_plan);
+    ModularFftTransform(values.begin(), values.end(), with_root.begin(), p, nt::PrimitiveRootModPrime(p));
+    assert(with_plan == with_root);
+
+    ModularFftInverseTransform(with_plan.begin(), with_plan.end(), with_plan.begin(), *first_plan);
+    assert(with_plan == values);
+}
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include <random>
+#include <numeric>
 
 #include <tests/benchmark_timer.h>
 #include <core/dft.h>
@@ -11,7 +12,9 @@
 #include <core/parallel_dft.h>
 
 #include <unistd.h>
+#include <sched.h>
 #include <string>
+#include <cassert>
 
 
 
@@ -94,7 +97,501 @@ void TestParallelCalls() {
     std::cout << "Sequential sum: " << seq_sum << std::endl;
 }
 
+// Every thread of the region writes its part of each phase, then checks
+// after the barrier that the whole phase was written by the other threads.
+void TestParallelRegion() {
+    const size_t N = 1 << 12;
+    const int num_phases = 50;
+
+    std::vector<int> array(N, -1);
+    std::atomic<int> errors(0);
+
+    auto run_phases = [&](const RegionContext& region) {
+        const auto [first, last] = region.share(N);
+        for (int phase = 0; phase < num_phases; phase++) {
+            for (size_t i = first; i < last; i++) {
+                array[i] = phase;
+            }
+            region.barrier();
+            for (size_t i = 0; i < N; i++) {
+                if (array[i] != phase) {
+                    errors.fetch_add(1);
+                }
+            }
+            region.barrier();
+        }
+    };
+
+    timeFunction([&](){ FixedThreadsParallelizer{6}.parallel_region(run_phases); }, "Fixed Threads parallel region");
+    timeFunction([&](){ OmpParallelizer{}.parallel_region(run_phases); }, "Omp parallel region");
+    timeFunction([&](){ ThreadPoolParallelizer{6}.parallel_region(run_phases); }, "Thread Pool parallel region");
+    timeFunction([&](){ WorkStealingParallelizer{6}.parallel_region(run_phases); }, "Work Stealing parallel region");
+
+    std::cout << "Parallel region errors: " << errors << std::endl;
+    assert(errors == 0);
+}
+
+// Many short parallel loops, for which creating threads on every call costs
+// more than the work, and nested calls that share the workers of the pool.
+void TestThreadPool() {
+    const size_t N = 1 << 10;
+    const size_t num_calls = 1000;
+
+    std::vector<int> array(N);
+    for (size_t i=0; i < N; i++) {
+        array[i] = rand() % 2;
+    }
+    const int seq_sum = std::accumulate(array.begin(), array.end(), 0);
+
+    std::atomic<int> par_sum(0);
+    auto foo = [&](int i){
+        par_sum.fetch_add(array[i]);
+    };
+
+    FixedThreadsParallelizer fixed_threads{6};
+    timeFunction([&](){
+        for (size_t r = 0; r < num_calls; r++) {
+            fixed_threads.parallel_for(0, N, foo);
+        }
+    }, "Fixed Threads short loops");
+
+    const ThreadPoolParallelizer pool{6};
+    timeFunction([&](){
+        for (size_t r = 0; r < num_calls; r++) {
+            pool.parallel_for(0, N, foo);
+        }
+    }, "Thread Pool short loops");
+
+    std::cout << "Parallel sum: " << par_sum << std::endl;
+    assert(par_sum == 2 * (int) num_calls * seq_sum);
+
+    par_sum = 0;
+    std::vector<std::function<void(void)>> funcs(8, [&](){
+        pool.parallel_calls({[&](){ pool.parallel_for(0, N, foo); }, [&](){ pool.parallel_for(0, N, foo); }});
+    });
+    pool.parallel_calls(funcs);
+    ThreadPoolParallelizer::Shared().parallel_for(0, N, foo);
+
+    std::cout << "Nested parallel sum: " << par_sum << std::endl;
+    assert(par_sum == 17 * seq_sum);
+}
+
+// More submitted tasks than the task queue of the pool holds, while its only
+// worker is busy, so that the rest go through the overflow queue.
+void TestThreadPoolOverflow() {
+    const ThreadPoolParallelizer pool{2};
+    const size_t num_tasks = 3 * ThreadPoolParallelizer::TASK_QUEUE_CAPACITY;
+
+    std::atomic<bool> release(false);
+    std::atomic<bool> blocking(false);
+    pool.submit([&](){
+        blocking = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!blocking) {
+        std::this_thread::yield();
+    }
+
+    std::vector<std::atomic<int>> num_runs(num_tasks);
+    for (size_t k = 0; k < num_tasks; k++) {
+        pool.submit([&num_runs, k](){ num_runs[k].fetch_add(1); });
+    }
+    assert(pool.stats().overflow == num_tasks - ThreadPoolParallelizer::TASK_QUEUE_CAPACITY);
+
+    // The calling thread and the worker share the tasks
+    release = true;
+    while (pool.run_pending_task()) {}
+
+    for (size_t k = 0; k < num_tasks; k++) {
+        while (num_runs[k] == 0) {
+            std::this_thread::yield();
+        }
+        assert(num_runs[k] == 1);
+    }
+
+    const auto stats = pool.stats();
+    std::cout << "Thread pool queue retries: push " << stats.push_retries << ", pop " << stats.pop_retries
+              << " - overflow " << stats.overflow << std::endl;
+}
+
+// Sum of an array by recursive halving down to ranges of 64 elements, with
+// parallel_calls at every level
+template < class Parallelizer >
+int RecursiveSum(const std::vector<int> &array, size_t first, size_t last, const Parallelizer &parallelizer) {
+    if (last - first <= 64) {
+        return std::accumulate(array.begin() + first, array.begin() + last, 0);
+    }
+
+    const size_t middle = first + (last - first) / 2;
+    int left = 0, right = 0;
+    parallelizer.parallel_calls({
+        [&](){ left = RecursiveSum(array, first, middle, parallelizer); },
+        [&](){ right = RecursiveSum(array, middle, last, parallelizer); },
+    });
+    return left + right;
+}
+
+void TestWorkStealing() {
+    const size_t N = 1 << 16;
+
+    std::vector<int> array(N);
+    for (size_t i=0; i < N; i++) {
+        array[i] = rand() % 2;
+    }
+    const int seq_sum = std::accumulate(array.begin(), array.end(), 0);
+
+    const ThreadPoolParallelizer pool{6};
+    const WorkStealingParallelizer work_stealing{6};
+
+    int pool_sum = 0, work_stealing_sum = 0;
+    timeFunction([&](){ pool_sum = RecursiveSum(array, 0, N, pool); }, "Thread Pool recursive sum");
+    timeFunction([&](){ work_stealing_sum = RecursiveSum(array, 0, N, work_stealing); }, "Work Stealing recursive sum");
+
+    std::atomic<int> par_sum(0);
+    work_stealing.parallel_for(0, N, [&](int i){ par_sum.fetch_add(array[i]); });
+    work_stealing.parallel_calls({[&](){ work_stealing.parallel_for(0, N, [&](int i){ par_sum.fetch_add(array[i]); }); }});
+
+    std::cout << "Recursive sums: " << pool_sum << " " << work_stealing_sum << std::endl;
+    std::cout << "Work Stealing parallel sum: " << par_sum << std::endl;
+    assert(pool_sum == seq_sum && work_stealing_sum == seq_sum);
+    assert(par_sum == 2 * seq_sum);
+}
+
+// Producers and consumers on a small MpmcQueue of move-only items: every
+// item comes out exactly once.
+void TestMpmcQueue() {
+    const size_t num_producers = 4;
+    const size_t num_consumers = 4;
+    const size_t items_per_producer = 1 << 15;
+    const size_t num_items = num_producers * items_per_producer;
+
+    MpmcQueue<std::unique_ptr<size_t>> queue(1 << 8);
+    std::vector<std::atomic<int>> seen(num_items);
+    std::atomic<size_t> num_popped(0);
+
+    timeFunction([&](){
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < num_producers; p++) {
+            threads.emplace_back([&, p](){
+                for (size_t i = 0; i < items_per_producer; i++) {
+                    auto item = std::make_unique<size_t>(p * items_per_producer + i);
+                    while (!queue.try_push(std::move(item))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (size_t c = 0; c < num_consumers; c++) {
+            threads.emplace_back([&](){
+                while (num_popped.load() < num_items) {
+                    if (auto item = queue.try_pop()) {
+                        seen[**item].fetch_add(1);
+                        num_popped.fetch_add(1);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }, "Mpmc queue producers and consumers");
+
+    const auto stats = queue.stats();
+    std::cout << "Mpmc queue retries: push " << stats.push_retries << ", pop " << stats.pop_retries
+              << " - full " << stats.full << ", empty " << stats.empty << std::endl;
+
+    assert(num_popped == num_items);
+    assert(!queue.try_pop().has_value());
+    for (size_t i = 0; i < num_items; i++) {
+        assert(seen[i] == 1);
+    }
+}
+
+// The budget of FixedThreadsParallelizer under nested and concurrent calls:
+// it never goes over its limit and is given back exactly.
+void TestThreadBudget() {
+    const size_t N = 1 << 12;
+
+    std::vector<std::complex<double>> x(N);
+    for (size_t i=0; i < N; i++) {
+        x[i] = std::complex<double>(rand() % 100, rand() % 100);
+    }
+    std::vector<std::complex<double>> expected(N);
+    iterative_fft::DFT(x.begin(), x.end(), expected.begin());
+
+    const FixedThreadsParallelizer fixed_threads{6};
+    const ThreadBudget &budget = fixed_threads.budget();
+
+    // Two calls share the 4 threads left by the outer call
+    std::vector<size_t> team_sizes(2);
+    fixed_threads.parallel_calls({
+        [&](){ fixed_threads.parallel_region([&](const RegionContext &ctx){ if (ctx.thread_id == 0) team_sizes[0] = ctx.num_threads; }); },
+        [&](){ fixed_threads.parallel_region([&](const RegionContext &ctx){ if (ctx.thread_id == 0) team_sizes[1] = ctx.num_threads; }); },
+    });
+    std::cout << "Nested team sizes: " << team_sizes[0] << " " << team_sizes[1] << std::endl;
+    assert(team_sizes[0] == 3 && team_sizes[1] == 3);
+    assert(budget.current() == 1);
+
+    // Concurrent transforms on one budget
+    const size_t num_transforms = 8;
+    std::vector<std::vector<std::complex<double>>> outputs(num_transforms, std::vector<std::complex<double>>(N));
+    timeFunction([&](){
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_transforms; t++) {
+            threads.emplace_back([&, t](){
+                iterative_fft::ParallelDFT(x.begin(), x.end(), outputs[t].begin(), fixed_threads);
+                recursive_fft::ParallelDFT(x.begin(), x.end(), outputs[t].begin(), fixed_threads);
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }, "Fixed Threads concurrent transforms");
+
+    for (const auto &output : outputs) {
+        for (size_t i = 0; i < N; i++) {
+            assert(std::abs(output[i] - expected[i]) < 1e-6 * N);
+        }
+    }
+
+    const int sum = RecursiveSum(std::vector<int>(N, 1), 0, N, fixed_threads);
+    assert(sum == (int) N);
+
+    std::cout << "Budget after the calls: " << budget.current() << ", peak " << budget.peak() << " of " << budget.limit() << std::endl;
+    assert(budget.current() == 1);
+    assert(budget.peak() <= budget.limit());
+}
+
+// The recursion of parallel_calls on OpenMP tasks, with loops inside the
+// tasks, against the same recursion on the thread pool.
+void TestOmpTasks() {
+    const size_t N = 1 << 16;
+
+    std::vector<int> array(N);
+    for (size_t i=0; i < N; i++) {
+        array[i] = rand() % 2;
+    }
+    const int seq_sum = std::accumulate(array.begin(), array.end(), 0);
+
+    const OmpParallelizer omp;
+    const OmpParallelizer omp_shallow{2};
+
+    int omp_sum = 0, omp_shallow_sum = 0;
+    timeFunction([&](){ omp_sum = RecursiveSum(array, 0, N, omp); }, "Omp recursive sum");
+    timeFunction([&](){ omp_shallow_sum = RecursiveSum(array, 0, N, omp_shallow); }, "Omp recursive sum - depth 2");
+
+    // Loops in the tasks run as taskloops of the enclosing region
+    std::atomic<int> par_sum(0);
+    std::vector<std::function<void(void)>> funcs(4, [&](){
+        omp.parallel_for(0, N, [&](int i){ par_sum.fetch_add(array[i]); });
+        omp.parallel_for(size_t{0}, N, 1000, [&](size_t first, size_t last){
+            par_sum.fetch_add(std::accumulate(array.begin() + first, array.begin() + last, 0));
+        });
+    });
+    omp.parallel_calls(funcs);
+
+    std::cout << "Omp recursive sums: " << omp_sum << " " << omp_shallow_sum << std::endl;
+    std::cout << "Omp nested parallel sum: " << par_sum << std::endl;
+    assert(omp_sum == seq_sum && omp_shallow_sum == seq_sum);
+    assert(par_sum == 8 * seq_sum);
+}
+
+// Pinned threads on the detected topology, which a single node machine
+// also checks: every thread of a team runs on its own CPU only, and the
+// calling thread gets its CPUs back.
+void TestThreadPlacement() {
+    const CpuTopology &topology = CpuTopology::Detect();
+    std::cout << "Topology: " << topology.num_nodes() << " nodes, " << topology.num_cpus() << " cpus" << std::endl;
+
+    const size_t num_threads = 4;
+    const FixedThreadsParallelizer pinned{num_threads, ThreadPlacement::kPinned};
+
+    cpu_set_t caller_mask;
+    sched_getaffinity(0, sizeof(caller_mask), &caller_mask);
+
+    std::vector<int> cpus(num_threads, -1);
+    std::atomic<int> num_misplaced(0);
+    pinned.parallel_region([&](const RegionContext &ctx) {
+        cpu_set_t mask;
+        sched_getaffinity(0, sizeof(mask), &mask);
+        const int expected = topology.cpu_of_thread(ctx.thread_id, ctx.num_threads);
+        if (CPU_COUNT(&mask) != 1 || !CPU_ISSET(expected, &mask) || sched_getcpu() != expected) {
+            num_misplaced++;
+        }
+        cpus[ctx.thread_id] = expected;
+    });
+
+    cpu_set_t mask_after;
+    sched_getaffinity(0, sizeof(mask_after), &mask_after);
+    assert(CPU_EQUAL(&caller_mask, &mask_after));
+    assert(num_misplaced == 0);
+
+    // Consecutive threads stay on the same node, the nodes in order
+    std::vector<size_t> nodes(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+        for (size_t node = 0; node < topology.num_nodes(); node++) {
+            const auto &node_cpus = topology.node_cpus(node);
+            if (std::find(node_cpus.begin(), node_cpus.end(), cpus[t]) != node_cpus.end()) {
+                nodes[t] = node;
+            }
+        }
+    }
+    assert(std::is_sorted(nodes.begin(), nodes.end()) || topology.num_cpus() < num_threads);
+
+    // Transforms through the first touched scratch buffer, pinned or not
+    const size_t N = 1 << 14;
+    std::vector<std::complex<double>> x(N), expected(N);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = std::complex<double>(rand() % 100, rand() % 100);
+    }
+    iterative_fft::DFT(x.begin(), x.end(), expected.begin());
+
+    const FixedThreadsParallelizer floating{num_threads};
+    for (const FixedThreadsParallelizer *parallelizer : {&floating, &pinned}) {
+        std::vector<std::complex<double>> data = x;
+        timeFunction([&](){
+            recursive_fft::ParallelDFT(data.begin(), data.end(), data.begin(), *parallelizer);
+        }, (parallelizer == &pinned) ? "Pinned threads transform" : "Floating threads transform");
+
+        for (size_t i = 0; i < N; i++) {
+            assert(std::abs(data[i] - expected[i]) < 1e-6 * N);
+        }
+    }
+
+    const FirstTouchBuffer<std::complex<double>> buffer(N, pinned);
+    assert(std::all_of(buffer.begin(), buffer.end(), [](const std::complex<double> &z){ return z == 0.0; }));
+}
+
+// Futures on a pool: chains, joins, waits from inside a task, and a pipeline
+// of transforms that overlaps the preparation of the next input.
+void TestAsync() {
+    const ThreadPoolParallelizer pool{4};
+
+    auto square = fft_async::Async(pool, [](){ return 12; }).then([](int x){ return x * x; });
+    auto half = square.then([](int x){ return x / 2; });
+    auto sum = fft_async::WhenAll(square, half).then([square, half](){ return square.get() + half.get(); });
+    assert(sum.get() == 144 + 72);
+
+    // A ready future is complete without any task and still chains on pool
+    auto ready = fft_async::Ready(12, pool);
+    assert(ready.is_ready() && ready.get() == 12);
+    assert(ready.then([](int x){ return x + 1; }).get() == 13);
+
+    // Waits inside the tasks for more tasks than there are workers
+    std::vector<fft_async::Future<int>> outer;
+    for (int k = 0; k < 16; k++) {
+        outer.push_back(fft_async::Async(pool, [&pool, k](){
+            return fft_async::Async(pool, [k](){ return k; }).get() + 1;
+        }));
+    }
+    int nested_sum = 0;
+    for (const auto &future : outer) {
+        nested_sum += future.get();
+    }
+    std::cout << "Async nested sum: " << nested_sum << std::endl;
+    assert(nested_sum == 16 * 17 / 2);
+
+    const size_t N = 1 << 14;
+    const size_t num_transforms = 8;
+
+    std::vector<std::vector<std::complex<double>>> inputs(num_transforms, std::vector<std::complex<double>>(N));
+    std::vector<std::vector<std::complex<double>>> outputs(num_transforms, std::vector<std::complex<double>>(N));
+    std::vector<std::vector<std::complex<double>>> expected(num_transforms, std::vector<std::complex<double>>(N));
+
+    // The input k + 1 is filled while the transforms of the inputs up to k
+    // run, then each round trip is checked against the input.
+    timeFunction([&](){
+        std::vector<fft_async::Future<void>> round_trips;
+        for (size_t k = 0; k < num_transforms; k++) {
+            for (size_t i = 0; i < N; i++) {
+                inputs[k][i] = std::complex<double>(rand() % 100, rand() % 100);
+            }
+
+            auto &input = inputs[k];
+            auto &output = outputs[k];
+            round_trips.push_back(iterative_fft::AsyncParallelDFT(input.begin(), input.end(), output.begin(), pool)
+                .then([&output, &pool](){
+                    iterative_fft::ParallelIDFT(output.begin(), output.end(), output.begin(), pool);
+                }));
+        }
+        for (const auto &future : round_trips) {
+            future.wait();
+        }
+    }, "Thread Pool async round trips");
+
+    for (size_t k = 0; k < num_transforms; k++) {
+        for (size_t i = 0; i < N; i++) {
+            assert(std::abs(outputs[k][i] - inputs[k][i]) < 1e-6);
+        }
+    }
+}
+
+// Templated parallel_for over ranges of 64-bit indices, beyond the range of
+// int, against the parallel_for that calls a std::function per index.
+template < class Parallelizer >
+void TestParallelForRanges(const Parallelizer &parallelizer, std::string title) {
+    const size_t N = 1 << 22;
+    const size_t offset = size_t{1} << 33;
+
+    std::atomic<size_t> index_sum(0);
+    parallelizer.parallel_for(offset, offset + N, 1000, [&](size_t i_first, size_t i_last) {
+        assert(i_first < i_last && i_last - i_first <= 1000);
+        size_t local_sum = 0;
+        for (size_t i = i_first; i < i_last; i++) {
+            local_sum += i - offset;
+        }
+        index_sum.fetch_add(local_sum);
+    });
+    assert(index_sum == N * (N - 1) / 2);
+
+    std::vector<int> array(N);
+    for (size_t i=0; i < N; i++) {
+        array[i] = rand() % 2;
+    }
+    const int seq_sum = std::accumulate(array.begin(), array.end(), 0);
+
+    std::vector<int> squares(N);
+    timeFunction([&](){
+        parallelizer.parallel_for(0, N, [&](int i){ squares[i] = array[i] * array[i]; });
+    }, title + " parallel_for - per index");
+    assert(std::accumulate(squares.begin(), squares.end(), 0) == seq_sum);
+
+    std::fill(squares.begin(), squares.end(), 0);
+    timeFunction([&](){
+        parallelizer.parallel_for(0, N, 1 << 14, [&](size_t i_first, size_t i_last) {
+            for (size_t i = i_first; i < i_last; i++) {
+                squares[i] = array[i] * array[i];
+            }
+        });
+    }, title + " parallel_for - ranges");
+    assert(std::accumulate(squares.begin(), squares.end(), 0) == seq_sum);
+
+    // Empty range and a grain larger than the range
+    parallelizer.parallel_for(5, 5, 10, [&](size_t, size_t){ assert(false); });
+    size_t calls = 0;
+    parallelizer.parallel_for(5, 8, 10, [&](size_t i_first, size_t i_last){ calls++; assert(i_first == 5 && i_last == 8); });
+    assert(calls == 1);
+}
+
 int main() {
     TestParallelFor();
     TestParallelCalls();
+    TestParallelRegion();
+    TestThreadPool();
+    TestThreadPoolOverflow();
+    TestWorkStealing();
+    TestMpmcQueue();
+    TestThreadBudget();
+    TestThreadPlacement();
+    TestAsync();
+    TestOmpTasks();
+
+    TestParallelForRanges(FixedThreadsParallelizer{6}, "Fixed Threads");
+    TestParallelForRanges(ThreadPoolParallelizer{6}, "Thread Pool");
+    TestParallelForRanges(WorkStealingParallelizer{6}, "Work Stealing");
+    TestParallelForRanges(OmpParallelizer{}, "Omp");
 }
\ No newline at end of file
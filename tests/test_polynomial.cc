@@ -19,6 +19,8 @@ static int RoundDouble(const double x) {
 
 void TestIntegerPolynomialMultiplication(const size_t degree = 10000, const int max_coef = 10000);
 void ComparePolynomialMultiplication(const size_t degree);
+void CompareRealMultiplyPrecision(const size_t degree);
+void TestAsyncMultiplication(const size_t degree, const size_t num_products);
 
 int main() {
     std::string line(50, '-');
@@ -32,6 +34,14 @@ int main() {
     TestIntegerPolynomialMultiplication(1 << 12, 100);
     std::cout << line << std::endl;
 
+    std::cout << ">>>precision, input size: 2^16\n";
+    CompareRealMultiplyPrecision(1 << 16);
+    std::cout << line << std::endl;
+
+    std::cout << ">>>async, input size: 2^12\n";
+    TestAsyncMultiplication(1 << 12, 8);
+    std::cout << line << std::endl;
+
     std::cout << ">>>input size: 2^18\n";
     ComparePolynomialMultiplication(1 << 18);
     std::cout << line << std::endl;
@@ -154,4 +164,93 @@ void ComparePolynomialMultiplication(const size_t degree) {
             std::cout << "\tGot: " << PQ_round[i] << "\n";
         }
     }
-}
\ No newline at end of file
+}
+
+void CompareRealMultiplyPrecision(const size_t degree) {
+    std::cout << "Testing Real Polynomial Multiplication precisions with degree " << degree << "\n";
+
+    auto generate_coefficients = [](auto num_coefs){
+        std::vector<int> out(num_coefs);
+        for (size_t i = 0; i < num_coefs; i++) {
+            out[i] = (random() % 200) - 100;
+        }
+        return out;
+    };
+
+    const Polynomial<int> P(generate_coefficients(degree));
+    const Polynomial<int> Q(generate_coefficients(degree));
+
+    const Polynomial<int> PQ = IntegerMultiply(P, Q);
+
+    auto measure = [&](auto zero, std::string title) {
+        using Float = decltype(zero);
+
+        Polynomial<Float> PQ_real;
+        timeFunction([&](){ PQ_real = RealMultiply<Float>(P, Q); }, "FFT Real Polynomial Multiply - " + title);
+
+        double max_error = 0;
+        for (size_t k = 0; k <= PQ.Degree(); k++) {
+            max_error = std::max(max_error, std::abs((double) PQ_real[k] - PQ[k]));
+        }
+        std::cout << "\tMax error " << title << ": " << max_error << "\n";
+    };
+
+    measure(0.0f, "float");
+    measure(0.0, "double");
+    measure(0.0L, "long double");
+}
+
+void TestAsyncMultiplication(const size_t degree, const size_t num_products) {
+    std::cout << "Testing Async Polynomial Multiplication with degree " << degree << "\n";
+
+    auto generate_coefficients = [](auto num_coefs){
+        std::vector<int> out(num_coefs);
+        for (size_t i = 0; i < num_coefs; i++) {
+            out[i] = (random() % 200) - 100;
+        }
+        return out;
+    };
+
+    std::vector<Polynomial<int>> P, Q;
+    for (size_t k = 0; k < num_products; k++) {
+        P.emplace_back(generate_coefficients(degree));
+        Q.emplace_back(generate_coefficients(degree - k));
+    }
+
+    std::vector<Polynomial<Complex>> PQ_blocking(num_products);
+    timeFunction([&](){
+        for (size_t k = 0; k < num_products; k++) {
+            PQ_blocking[k] = ComplexMultiply(P[k], Q[k]);
+        }
+    }, "FFT Complex Polynomial Multiply - one by one");
+
+    // All of the products in flight at once, each followed by its rounding
+    std::vector<fft_async::Future<Polynomial<int>>> PQ_async(num_products);
+    timeFunction([&](){
+        for (size_t k = 0; k < num_products; k++) {
+            PQ_async[k] = AsyncComplexMultiply(P[k], Q[k]).then([](const Polynomial<Complex> &PQ_complex){
+                Polynomial<int> PQ_round;
+                PQ_round.SetCoefficient(PQ_complex.Degree(), 1);
+                for (size_t i = 0; i <= PQ_complex.Degree(); i++) {
+                    PQ_round.SetCoefficient(i, RoundDouble(PQ_complex[i].real()));
+                }
+                return PQ_round;
+            });
+        }
+        for (const auto &future : PQ_async) {
+            future.wait();
+        }
+    }, "FFT Complex Polynomial Multiply - async");
+
+    for (size_t k = 0; k < num_products; k++) {
+        const Polynomial<int> PQ = IntegerMultiply(P[k], Q[k]);
+        const Polynomial<int> &PQ_round = PQ_async[k].get();
+
+        assert(PQ.Degree() == PQ_round.Degree());
+        assert(PQ_blocking[k].Degree() == PQ.Degree());
+        for (size_t i = 0; i <= PQ.Degree(); i++) {
+            assert(PQ[i] == PQ_round[i]);
+            assert(RoundDouble(PQ_blocking[k][i].real()) == PQ[i]);
+        }
+    }
+}